@@ -0,0 +1,355 @@
+//
+//  TS01_analyze.cc
+//  ts_01
+//
+//  ts01_analyze: reduce ts_01 text output (domrun.dat, fibrun-*.dat) to
+//  per-run statistics.  Only the lines TS01_PhotoSD and TS01_RunAction
+//  print are read, with or without the G4WTn prefix of worker threads:
+//
+//      SD-S <time [ns]> <wavelength [nm]>     one per hit
+//      SD-W <unweighted> <weighted>           one per event
+//      SD-T ...                               end of a run
+//
+//  everything else (G4Event::Print, run manager chatter) is skipped.  The
+//  file is memory-mapped and cut into one chunk per thread at line
+//  boundaries; each chunk is parsed independently, and the runs it
+//  contains are matched up afterwards by counting SD-T lines.  Sums are
+//  fixed point as in TS01_Run, so the output does not depend on the
+//  number of threads.
+//
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "TS01_Histogram.hh"
+
+namespace
+{
+    enum { kHits, kWeightedHits, kTime, kWavelength, kNumHistograms };
+
+    // Same binning as the in-memory histograms of TS01_RunAction
+    TS01_Histogram MakeHistogram(G4int i)
+    {
+        switch (i)
+        {
+            case kHits:         return TS01_Histogram("hits", 100, 0.0, 100.0);
+            case kWeightedHits: return TS01_Histogram("weighted_hits", 100, 0.0, 25.0);
+            case kTime:         return TS01_Histogram("time_ns", 200, 0.0, 200.0);
+            default:            return TS01_Histogram("wavelength_nm", 80, 300.0, 700.0);
+        }
+    }
+
+    // Results of one run, or of the part of a run seen by one chunk
+    struct RunPart
+    {
+        RunPart() : events(0), events_hit(0), photons(0)
+        {
+            for (G4int i=0; i<kNumHistograms; i++) histograms[i] = MakeHistogram(i);
+        }
+
+        void Add(const RunPart& other)
+        {
+            events     += other.events;
+            events_hit += other.events_hit;
+            photons    += other.photons;
+            sum_u  += other.sum_u;  sum_w  += other.sum_w;
+            sum_u2 += other.sum_u2; sum_w2 += other.sum_w2;
+            for (G4int i=0; i<kNumHistograms; i++) histograms[i].Merge(other.histograms[i]);
+        }
+
+        long       events, events_hit, photons;
+        TS01_Fixed sum_u, sum_w, sum_u2, sum_w2;
+        TS01_Histogram histograms[kNumHistograms];
+    };
+
+    struct Chunk
+    {
+        const char* begin;
+        const char* end;
+        std::vector<RunPart> runs;      // a new part after every SD-T line
+        long lines, bad;
+    };
+
+    const double kPow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    // Number at p, up to end; returns the character after it or NULL.
+    // Up to 15 significant digits with |exponent| <= 22 the result is one
+    // exact multiplication or division, correctly rounded like strtod;
+    // anything else (long mantissas, inf, nan) goes to strtod.
+    const char* ParseNumber(const char* p, const char* end, double& x)
+    {
+        while (p < end && *p == ' ') p++;
+        const char* start = p;
+
+        G4bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+        uint64_t mantissa = 0;
+        G4int digits = 0, exp10 = 0;
+        for (; p < end && (unsigned) (*p - '0') < 10; p++, digits++)
+            mantissa = mantissa * 10 + (*p - '0');
+        if (p < end && *p == '.')
+        {
+            for (p++; p < end && (unsigned) (*p - '0') < 10; p++, digits++, exp10--)
+                mantissa = mantissa * 10 + (*p - '0');
+        }
+        if (digits > 0 && p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char* q = p + 1;
+            G4bool exp_negative = false;
+            if (q < end && (*q == '-' || *q == '+')) exp_negative = (*q++ == '-');
+            G4int e = 0, exp_digits = 0;
+            for (; q < end && (unsigned) (*q - '0') < 10 && exp_digits < 6; q++, exp_digits++)
+                e = e * 10 + (*q - '0');
+            if (exp_digits > 0)
+            {
+                exp10 += exp_negative ? -e : e;
+                p = q;
+            }
+        }
+        const G4bool delimited = p == end || *p == ' ' || *p == '\n' || *p == '\r';
+
+        if (digits > 0 && digits <= 15 && exp10 >= -22 && exp10 <= 22 && delimited)
+        {
+            x = exp10 < 0 ? mantissa / kPow10[-exp10] : mantissa * kPow10[exp10];
+            if (negative) x = -x;
+            return p;
+        }
+
+        char token[64];
+        size_t n = 0;
+        for (p = start; p < end && *p != ' ' && *p != '\n' && *p != '\r' && n < sizeof(token) - 1; p++)
+            token[n++] = *p;
+        token[n] = '\0';
+        char* tail;
+        x = strtod(token, &tail);
+        return (n > 0 && *tail == '\0') ? p : NULL;
+    }
+
+    void ParseChunk(Chunk& chunk)
+    {
+        chunk.runs.assign(1, RunPart());
+        chunk.lines = 0;
+        chunk.bad = 0;
+
+        const char* p = chunk.begin;
+        while (p < chunk.end)
+        {
+            const char* eol = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+            if (eol == NULL) eol = chunk.end;
+            const char* line = p;
+            p = eol + 1;
+            chunk.lines++;
+
+            // Worker output is prefixed "G4WTn > "
+            if (eol - line > 4 && memcmp(line, "G4WT", 4) == 0)
+            {
+                const char* gt = static_cast<const char*>(memchr(line, '>', std::min<long>(eol - line, 16)));
+                if (gt == NULL) continue;
+                line = gt + 1;
+                while (line < eol && *line == ' ') line++;
+            }
+            if (eol - line < 5 || memcmp(line, "SD-", 3) != 0 || line[4] != ' ') continue;
+
+            RunPart& run = chunk.runs.back();
+            double a, b;
+            const char* q = line + 5;
+            switch (line[3])
+            {
+                case 'S':
+                    if ((q = ParseNumber(q, eol, a)) == NULL || ParseNumber(q, eol, b) == NULL)
+                    {
+                        chunk.bad++;
+                        break;
+                    }
+                    run.photons++;
+                    run.histograms[kTime].Fill(a);
+                    run.histograms[kWavelength].Fill(b);
+                    break;
+                case 'W':
+                    if ((q = ParseNumber(q, eol, a)) == NULL || ParseNumber(q, eol, b) == NULL)
+                    {
+                        chunk.bad++;
+                        break;
+                    }
+                    run.events++;
+                    if (a > 0.0) run.events_hit++;
+                    run.sum_u  += a;
+                    run.sum_w  += b;
+                    run.sum_u2 += a*a;
+                    run.sum_w2 += b*b;
+                    run.histograms[kHits].Fill(a);
+                    run.histograms[kWeightedHits].Fill(b);
+                    break;
+                case 'T':
+                    chunk.runs.push_back(RunPart());
+                    break;
+            }
+        }
+    }
+
+    void WriteRun(std::ostream& os, G4int id, const RunPart& run)
+    {
+        const long   n    = run.events;
+        const double u    = run.sum_u.ToDouble(), w = run.sum_w.ToDouble();
+        const double mu_u = n > 0 ? u / n : 0.0;
+        const double mu_w = n > 0 ? w / n : 0.0;
+        const double sd_u = n > 0 ? sqrt(fmax(run.sum_u2.ToDouble() / n - mu_u*mu_u, 0.0)) : 0.0;
+        const double sd_w = n > 0 ? sqrt(fmax(run.sum_w2.ToDouble() / n - mu_w*mu_w, 0.0)) : 0.0;
+
+        os << "run " << id << "\n"
+           << "events " << n << "\n"
+           << "hits " << run.sum_u << " " << run.sum_w << " " << run.sum_u2 << " "
+           << run.sum_w2 << "\n"
+           << "efficiency " << (n > 0 ? (double) run.events_hit / n : 0.0) << "\n"
+           << "per_event " << mu_u << " " << sd_u << " " << mu_w << " " << sd_w << "\n"
+           << "photons " << run.photons << "\n";
+        for (G4int i=0; i<kNumHistograms; i++) run.histograms[i].Write(os);
+    }
+
+    G4bool Analyze(const char* file, G4int n_threads, std::ostream& os)
+    {
+        const int fd = open(file, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+            fprintf(stderr, "ts01_analyze: cannot read %s\n", file);
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        const size_t size = st.st_size;
+        const char* data = NULL;
+        if (size > 0)
+        {
+            void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED)
+            {
+                fprintf(stderr, "ts01_analyze: cannot map %s\n", file);
+                close(fd);
+                return false;
+            }
+            madvise(map, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(map);
+        }
+        const auto t0 = std::chrono::steady_clock::now();
+
+        // Chunks end after a newline, so no line is split between threads
+        std::vector<Chunk> chunks(std::max<size_t>(1, std::min<size_t>(n_threads, size / 65536 + 1)));
+        const char* p = data;
+        for (size_t c=0; c<chunks.size(); c++)
+        {
+            const char* end = data + size * (c + 1) / chunks.size();
+            if (end < p) end = p;
+            const char* eol = end < data + size ?
+                static_cast<const char*>(memchr(end, '\n', data + size - end)) : NULL;
+            end = eol ? eol + 1 : data + size;
+            chunks[c].begin = p;
+            chunks[c].end   = end;
+            p = end;
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t c=1; c<chunks.size(); c++) threads.push_back(std::thread(ParseChunk, std::ref(chunks[c])));
+        ParseChunk(chunks[0]);
+        for (size_t t=0; t<threads.size(); t++) threads[t].join();
+
+        // Part k of a chunk belongs to the run after the SD-T lines before it
+        std::vector<RunPart> runs;
+        long lines = 0, bad = 0;
+        size_t run_id = 0;
+        for (size_t c=0; c<chunks.size(); c++)
+        {
+            for (size_t k=0; k<chunks[c].runs.size(); k++)
+            {
+                if (k > 0) run_id++;
+                if (runs.size() <= run_id) runs.resize(run_id + 1);
+                runs[run_id].Add(chunks[c].runs[k]);
+            }
+            lines += chunks[c].lines;
+            bad   += chunks[c].bad;
+        }
+        // Nothing after the last SD-T
+        if (runs.size() > 1 && runs.back().events == 0 && runs.back().photons == 0) runs.pop_back();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        fprintf(stderr, "ts01_analyze: %s, %ld lines, %zu runs, %zu threads, %.3f s (%.0f MB/s)%s\n",
+                file, lines, runs.size(), chunks.size(), seconds,
+                seconds > 0.0 ? size / seconds / 1e6 : 0.0, bad > 0 ? ", unreadable SD lines" : "");
+
+        const std::streamsize precision = os.precision(17);
+        os << "file " << file << "\n";
+        for (size_t r=0; r<runs.size(); r++) WriteRun(os, r, runs[r]);
+        os.precision(precision);
+
+        if (data) munmap(const_cast<char*>(data), size);
+        close(fd);
+        return true;
+    }
+
+    void print_help(void)
+    {
+        fprintf(stderr,
+                "usage: ts01_analyze [ options ] <file> ...\n"
+                "  options are ...\n"
+                "  -h           this help\n"
+                "  -t <threads> Parse with <threads> threads (default: one per core)\n"
+                "  -o <file>    Write the results to <file> instead of stdout\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    G4int n_threads = std::thread::hardware_concurrency();
+    const char* out_file = NULL;
+
+    int ch;
+    while ((ch = getopt(argc, argv, "t:o:h")) != -1)
+    {
+        switch (ch)
+        {
+            case 't':
+                n_threads = strtol(optarg, NULL, 0);
+                break;
+            case 'o':
+                out_file = optarg;
+                break;
+            case 'h':
+            default:
+                print_help();
+        }
+    }
+    if (optind >= argc) print_help();
+    if (n_threads < 1) n_threads = 1;
+
+    std::ofstream file_os;
+    if (out_file)
+    {
+        file_os.open(out_file);
+        if (!file_os)
+        {
+            fprintf(stderr, "ts01_analyze: cannot write %s\n", out_file);
+            return 1;
+        }
+    }
+    std::ostream& os = out_file ? file_os : std::cout;
+
+    G4int rc = 0;
+    for (G4int i=optind; i<argc; i++)
+        if (!Analyze(argv[i], n_threads, os)) rc = 1;
+    return rc;
+}
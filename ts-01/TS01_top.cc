@@ -10,10 +10,10 @@
  * (C) 2016 Kael HANSON
  */
 
+#include "G4RunManager.hh"
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
-#else
-#include "G4RunManager.hh"
+#include "G4Threading.hh"
 #endif
 
 #include "Randomize.hh"
@@ -25,10 +25,22 @@
 #include "TS01_DetectorConstruction.hh"
 #include "TS01_PhysicsList.hh"
 #include "TS01_ActionInitialization.hh"
+#include "TS01_Sweep.hh"
+#include "TS01_Bench.hh"
+#include "TS01_Shard.hh"
+#include "TS01_Checkpoint.hh"
+#include "TS01_OpticalCache.hh"
+#include "TS01_IceModel.hh"
+#include "TS01_Telemetry.hh"
+#include "TS01_Run.hh"
 #include "G4SystemOfUnits.hh"
 
 #include <unistd.h>
+#include <getopt.h>
 #include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
 
 void print_help(void)
 {
@@ -39,24 +51,193 @@ void print_help(void)
             "  -B <file>    batch mode with commands from <file>\n"
             "  -D           DOM mode (default)\n"
             "  -F           Fiber OM mode\n"
+            "  -P           Build the fiber ring as a parameterised volume\n"
             "  -r <radius>  Set detector radius [cm]\n"
             "  -d <dia.>    Set fiber diameter [mm]\n"
-            "  -n <n_fiber> Set number of fibers around circle\n");
+            "  -n <n_fiber> Set number of fibers around circle\n"
+            "  -S <seed>    Set random seed\n"
+            "  -t <threads> Multithreaded mode with <threads> workers\n"
+            "               (0 = one per core, default sequential)\n"
+            "  --physics-cache <dir>\n"
+            "               Store/retrieve physics tables under <dir>\n"
+            "  --fiber-fastsim\n"
+            "               Fast simulation of light guided along the fibers\n"
+            "               (/param/InActivateModel TS01_FiberLightGuide\n"
+            "               switches back to full tracking)\n"
+            "  --optics-cache\n"
+            "               Optical absorption and WLS lengths from uniform-grid\n"
+            "               tables (/ts01/optics/benchmark times the lookups)\n"
+            "  --cascade    Register the parametrised cascade light process for\n"
+            "               e-, e+ and gamma (/ts01/cascade/enable switches it on)\n"
+            "  --ice-model <file>\n"
+            "               Layered ice with scattering (TS01_IceModel.hh for\n"
+            "               the file format)\n"
+            "  --bench-json <file>\n"
+            "               Append one JSON benchmark record per run to <file>\n"
+            "  --telemetry <socket>\n"
+            "               Serve live run status as JSON on a Unix socket\n"
+            "               (e.g. nc -U <socket>)\n"
+            "  --first-event <n>\n"
+            "  --num-events <n>\n"
+            "               Process events n.. (at most <n>) of every run, seeded\n"
+            "               as in the unsharded run\n"
+            "  --resume <checkpoint>\n"
+            "               Continue the runs of an interrupted job from a\n"
+            "               /ts01/checkpoint/ file\n"
+            "  --merge-summaries <out> <file> ...\n"
+            "               Sum the run summaries of sharded jobs into <out>\n");
     exit(1);
 }
 
-int main(int argc, char** argv)
+enum {
+    OPT_PHYSICS_CACHE = 256,
+    OPT_FIBER_FASTSIM,
+    OPT_OPTICS_CACHE,
+    OPT_ICE_MODEL,
+    OPT_CASCADE,
+    OPT_BENCH_JSON,
+    OPT_TELEMETRY,
+    OPT_FIRST_EVENT,
+    OPT_NUM_EVENTS,
+    OPT_MERGE_SUMMARIES,
+    OPT_RESUME
+};
+
+static struct option long_options[] = {
+    { "physics-cache", required_argument, NULL, OPT_PHYSICS_CACHE },
+    { "fiber-fastsim", no_argument,       NULL, OPT_FIBER_FASTSIM },
+    { "optics-cache",  no_argument,       NULL, OPT_OPTICS_CACHE },
+    { "ice-model",     required_argument, NULL, OPT_ICE_MODEL },
+    { "cascade",       no_argument,       NULL, OPT_CASCADE },
+    { "bench-json",    required_argument, NULL, OPT_BENCH_JSON },
+    { "telemetry",     required_argument, NULL, OPT_TELEMETRY },
+    { "first-event",   required_argument, NULL, OPT_FIRST_EVENT },
+    { "num-events",    required_argument, NULL, OPT_NUM_EVENTS },
+    { "merge-summaries", required_argument, NULL, OPT_MERGE_SUMMARIES },
+    { "resume",        required_argument, NULL, OPT_RESUME },
+    { "help",          no_argument,       NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+};
+
+/*
+ * Sum the summary files (/ts01/histo/file) of jobs that processed
+ * different event ranges of the same runs; run blocks are matched in
+ * order and must agree in run number and geometry, and every file must
+ * hold the same number of runs.  Sums are fixed point, so the result
+ * does not depend on how the events were split.  The output is only
+ * written when every input merged.
+ */
+int merge_summaries(const G4String& out_file, const std::vector<G4String>& files)
 {
+    std::vector<std::ifstream*> inputs;
+    G4int n_runs = 0, rc = 0;
+    for (size_t i=0; i<files.size(); i++)
+    {
+        inputs.push_back(new std::ifstream(files[i].c_str()));
+        if (!*inputs.back())
+        {
+            fprintf(stderr, "ts_01: cannot read %s\n", files[i].c_str());
+            rc = 1;
+        }
+    }
+    std::ostringstream os;
     
+    for (;;)
+    {
+        TS01_Histogram binning[TS01_Run::kNumHistograms];
+        std::vector<TS01_Run*> parts;
+        G4String run_line, geometry;
+        size_t ended = 0;
+        for (size_t i=0; i<inputs.size() && rc == 0; i++)
+        {
+            G4String line, geo, end;
+            if (!std::getline(*inputs[i], line) || line == "")
+            {
+                ended++;
+                continue;
+            }
+            std::getline(*inputs[i], geo);
+            
+            TS01_Run* part = new TS01_Run(binning);
+            parts.push_back(part);
+            if (line.compare(0, 4, "run ") != 0 || !part->ReadSummary(*inputs[i]) ||
+                !(*inputs[i] >> end) || end != "end" ||
+                (parts.size() > 1 && (line != run_line || geo != geometry)))
+            {
+                fprintf(stderr, "ts_01: %s: bad or mismatched run block %d\n", files[i].c_str(), n_runs);
+                rc = 1;
+            }
+            inputs[i]->ignore(1);       // newline after "end"
+            run_line = line;
+            geometry = geo;
+        }
+        if (rc == 0 && ended > 0 && !parts.empty())
+        {
+            fprintf(stderr, "ts_01: run block %d missing from %d of %d files\n",
+                    n_runs, (int) ended, (int) inputs.size());
+            rc = 1;
+        }
+        
+        if (rc == 0 && !parts.empty())
+        {
+            for (G4int h=0; h<TS01_Run::kNumHistograms; h++) binning[h] = parts[0]->GetHistogram(h);
+            TS01_Run total(binning);
+            for (size_t i=0; i<parts.size(); i++) total.Merge(parts[i]);
+            
+            os << run_line << "\n" << geometry << "\n";
+            total.WriteSummary(os);
+            os << "end\n";
+            n_runs++;
+        }
+        for (size_t i=0; i<parts.size(); i++) delete parts[i];
+        if (rc != 0 || parts.empty()) break;
+    }
+    
+    for (size_t i=0; i<inputs.size(); i++) delete inputs[i];
+    if (rc != 0)
+    {
+        fprintf(stderr, "ts_01: %s not written\n", out_file.c_str());
+        return rc;
+    }
+    
+    std::ofstream out(out_file.c_str());
+    out << os.str();
+    out.close();
+    if (!out)
+    {
+        fprintf(stderr, "ts_01: cannot write %s\n", out_file.c_str());
+        return 1;
+    }
+    fprintf(stderr, "ts_01: %d runs from %d files merged into %s\n",
+            n_runs, (int) files.size(), out_file.c_str());
+    return rc;
+}
+
+int main(int argc, char** argv)
+{
+    // Starts the initialisation clock
+    TS01_Bench* bench = TS01_Bench::Instance();
+
     long seed = 0x7B81AF65;
     G4String macroFile;
     bool     doFiber = false;
+    bool     paramRing = false;
     G4double fiber_d = 1.0*mm;
     G4double radius  = 10.0*cm;
     G4int    n_fib   = 120;
+    G4int    n_threads = -1;
+    G4String physics_cache;
+    bool     fiberFastSim = false;
+    bool     cascade = false;
+    G4String merge_file;
+    G4String resume_file;
+    G4String ice_file;
+    G4String telemetry_path;
+    TS01_Shard* shard = TS01_Shard::Instance();
+    TS01_Telemetry* telemetry = TS01_Telemetry::Instance();
     
     int ch;
-    while ((ch = getopt(argc, argv, "S:B:r:d:n:DFh")) != -1)
+    while ((ch = getopt_long(argc, argv, "S:B:r:d:n:t:DFPh", long_options, NULL)) != -1)
     {
         switch (ch)
         {
@@ -72,6 +253,9 @@ int main(int argc, char** argv)
             case 'F':
                 doFiber = true;
                 break;
+            case 'P':
+                paramRing = true;
+                break;
             case 'r':
                 radius = strtod(optarg, NULL) * CLHEP::cm;
                 break;
@@ -81,20 +265,94 @@ int main(int argc, char** argv)
             case 'n':
                 n_fib = strtol(optarg, NULL, 0);
                 break;
+            case 't':
+                n_threads = strtol(optarg, NULL, 0);
+                break;
+            case OPT_PHYSICS_CACHE:
+                physics_cache = G4String(optarg);
+                break;
+            case OPT_FIBER_FASTSIM:
+                fiberFastSim = true;
+                break;
+            case OPT_OPTICS_CACHE:
+                TS01_OpticalCache::Instance()->SetEnabled(true);
+                break;
+            case OPT_ICE_MODEL:
+                ice_file = G4String(optarg);
+                break;
+            case OPT_CASCADE:
+                cascade = true;
+                break;
+            case OPT_BENCH_JSON:
+                bench->SetFile(G4String(optarg));
+                break;
+            case OPT_TELEMETRY:
+                telemetry_path = G4String(optarg);
+                break;
+            case OPT_FIRST_EVENT:
+                shard->SetFirstEvent(strtol(optarg, NULL, 0));
+                break;
+            case OPT_NUM_EVENTS:
+                shard->SetNumberOfEvents(strtol(optarg, NULL, 0));
+                break;
+            case OPT_MERGE_SUMMARIES:
+                merge_file = G4String(optarg);
+                break;
+            case OPT_RESUME:
+                resume_file = G4String(optarg);
+                break;
             case 'h':
+            default:
                 print_help();
         }
     }
         
+    if (merge_file != "")
+        return merge_summaries(merge_file, std::vector<G4String>(argv + optind, argv + argc));
+    
+    // Events are reseeded from (seed, run, event) as they start
     G4Random::setTheEngine(new CLHEP::MTwistEngine(seed));
+    shard->SetSeed(seed);
+    if (resume_file != "" && !TS01_Checkpoint::Instance()->Resume(resume_file))
+        return 1;
+    if (ice_file != "" && !TS01_IceModel::Instance()->Load(ice_file))
+        return 1;
+    if (telemetry_path != "" && !telemetry->Start(telemetry_path))
+        return 1;
     
+#ifdef G4MULTITHREADED
+    G4RunManager* runManager;
+    if (n_threads >= 0)
+    {
+        G4MTRunManager* mtRunManager = new G4MTRunManager;
+        mtRunManager->SetNumberOfThreads(n_threads > 0 ? n_threads : G4Threading::G4GetNumberOfCores());
+        runManager = mtRunManager;
+    }
+    else
+        runManager = new G4RunManager;
+#else
+    if (n_threads >= 0)
+        fprintf(stderr, "ts_01: built without G4MULTITHREADED, ignoring -t\n");
     G4RunManager* runManager = new G4RunManager;
-    runManager->SetUserInitialization(new TS01_DetectorConstruction(doFiber, n_fib, fiber_d, radius));
-    runManager->SetUserInitialization(new TS01_PhysicsList);
+#endif
+    TS01_DetectorConstruction* detector = new TS01_DetectorConstruction(doFiber, n_fib, fiber_d, radius);
+    detector->SetParameterisedRing(paramRing);
+    detector->SetFiberFastSim(fiberFastSim);
+    runManager->SetUserInitialization(detector);
+    TS01_PhysicsList* physics = new TS01_PhysicsList;
+    if (physics_cache != "") physics->SetPhysicsCache(physics_cache);
+    if (fiberFastSim) physics->EnableFastSimulation();
+    if (cascade) physics->EnableCascade();
+    runManager->SetUserInitialization(physics);
     runManager->SetUserInitialization(new TS01_ActionInitialization);
     
+    // /ts01/sweep/ commands
+    TS01_Sweep* sweep = new TS01_Sweep(detector);
+    
     G4UImanager* UImanager = G4UImanager::GetUIpointer();
     
+    if (bench->IsEnabled()) bench->SetLabel(macroFile);
+    
     if (macroFile == "")
     {
         G4UIExecutive *ui = new G4UIExecutive(argc, argv);
@@ -110,7 +368,9 @@ int main(int argc, char** argv)
         UImanager->ApplyCommand(cmd+macroFile);
     }
     
+    delete sweep;
 	delete runManager;
+    telemetry->Stop();
     
 	return 0;
 }
@@ -0,0 +1,152 @@
+//
+//  TS01_AcceptanceTable.hh
+//  ts_01
+//
+//  Detection probability of an optical photon born in the ice, binned in
+//  cylindrical position (rho, z), direction (cos theta and the azimuth
+//  relative to the radial direction, |dphi|) and wavelength.  The DOM is
+//  symmetric about the z axis, so the photon azimuth is not binned; a
+//  fiber ring only nearly is, and tables are refused for rings whose
+//  fibers are further apart than a rho bin.  Wavelengths beyond the axis
+//  (by default the 250-650 nm of the ice RINDEX) take its edge bins.
+//
+//  A table is only used with the geometry, ice optics, layered ice model
+//  (--ice-model) and spectral responses it was built with.
+//
+//  In build mode TS01_PrimaryGenerator injects photons into one bin per
+//  event, cycling through the bins, and TS01_Run accumulates the SD-W
+//  counts per bin.  In fast mode TS01_Cerenkov folds the Cherenkov light
+//  of every charged step with the table without creating photons, and
+//  TS01_StackingAction looks up every other new optical photon; both add
+//  the probabilities to TS01_PhotoSD.
+//
+
+#ifndef TS01_AcceptanceTable_h
+#define TS01_AcceptanceTable_h
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class TS01_DetectorConstruction;
+
+// The detector a table was built for: every dimension it is built from
+// [mm, deg].  Those of the other detector type are left zero.
+struct TS01_AcceptanceGeometry
+{
+    int32_t  fiber_mode;
+    int32_t  num_fiber;
+    double   fiber_dia, fiber_len, det_radius;
+    double   pmt_radius, pmt_face_z, pmt_body_z;
+    double   dom_radius, dom_glass;
+    double   dom_pmt_radius, dom_pmt_glass, dom_pmt_theta;
+    double   world_half;
+};
+
+struct TS01_AcceptanceHeader
+{
+    char     magic[8];      // "TS01ACC"
+    uint32_t version;
+    TS01_AcceptanceGeometry geometry;
+    uint64_t ice;           // hash of the ice optical properties and layered ice model
+    uint64_t response;      // hash of the spectral responses
+    int32_t  photons;       // photons injected per event
+    int32_t  nbins[5];
+    double   lo[5], hi[5];  // rho, z [mm], cos theta, |dphi| [rad], wavelength [nm]
+};
+
+class TS01_AcceptanceTable
+{
+public:
+    static const uint32_t version = 4;
+
+    enum { kRho, kZ, kCosTheta, kDPhi, kWavelength, kNumAxes };
+
+    TS01_AcceptanceTable();
+
+    void  SetBinning(G4int axis, G4int nbins, G4double lo, G4double hi);
+    void  SetPhotonsPerEvent(G4int n) { photons = n; }
+    G4int GetPhotonsPerEvent() const  { return photons; }
+    G4int GetNumberOfBins() const;
+
+    // Allocate for the current binning and clear the contents
+    void Reset();
+    void Merge(const TS01_AcceptanceTable& other);
+
+    // Build mode: event i injects into bin i modulo the number of bins
+    G4int InjectionBin(G4int event_id) const { return event_id % GetNumberOfBins(); }
+    void  SamplePhoton(G4int bin, G4ThreeVector& x, G4ThreeVector& u, G4double& wl) const;
+    void  AddInjection(G4int bin, G4double unweighted, G4double weighted)
+    {
+        injected[bin]   += photons;
+        detected_u[bin] += unweighted;
+        detected_w[bin] += weighted;
+    }
+
+    // Fast mode: detection probabilities (unweighted, QE-weighted) of a
+    // photon at x going along u with wavelength wl [nm]; zero outside
+    inline void Lookup(const G4ThreeVector& x, const G4ThreeVector& u, G4double wl,
+                       G4double& p_u, G4double& p_w) const
+    {
+        const G4int bin = FindBin(x, u, wl);
+        if (bin < 0) { p_u = p_w = 0.0; return; }
+        p_u = prob_u[bin];
+        p_w = prob_w[bin];
+    }
+
+    // A table is only read back for the geometry, ice and responses it
+    // was written for; otherwise Read returns false and the table is not
+    // to be used
+    G4bool Write(const G4String& file, const TS01_DetectorConstruction* det) const;
+    G4bool Read(const G4String& file, const TS01_DetectorConstruction* det);
+
+    // False, with a warning, for a fiber ring too sparse to be taken as
+    // symmetric about the z axis at the current rho binning
+    G4bool CheckSymmetry(const TS01_DetectorConstruction* det) const;
+
+private:
+    inline G4int AxisBin(G4int axis, G4double v) const
+    {
+        if (!(v >= lo[axis] && v <= hi[axis])) return -1;
+        const G4int i = (G4int) ((v - lo[axis]) * inv_width[axis]);
+        return i < nbins[axis] ? i : nbins[axis] - 1;
+    }
+    inline G4int EdgeBin(G4int axis, G4double v) const
+    {
+        const G4double f = (v - lo[axis]) * inv_width[axis];
+        return !(f > 0.0) ? 0 : f < nbins[axis] ? (G4int) f : nbins[axis] - 1;
+    }
+    inline G4int FindBin(const G4ThreeVector& x, const G4ThreeVector& u, G4double wl) const
+    {
+        const G4double rho = x.perp();
+        const G4double ut  = u.perp();
+        const G4double c   = (rho > 0.0 && ut > 0.0) ? (x.x()*u.x() + x.y()*u.y()) / (rho*ut) : 1.0;
+        const G4int i[kNumAxes] = {
+            AxisBin(kRho, rho), AxisBin(kZ, x.z()), AxisBin(kCosTheta, u.z()),
+            AxisBin(kDPhi, acos(fmax(-1.0, fmin(1.0, c)))), EdgeBin(kWavelength, wl)
+        };
+        G4int bin = 0;
+        for (G4int a=0; a<kNumAxes; a++)
+        {
+            if (i[a] < 0) return -1;
+            bin = bin*nbins[a] + i[a];
+        }
+        return bin;
+    }
+    void UpdateProbabilities();
+    static void DescribeGeometry(const TS01_DetectorConstruction* det, TS01_AcceptanceGeometry& g);
+    static uint64_t IceHash();
+    static uint64_t ResponseHash(const TS01_DetectorConstruction* det);
+
+    G4int    photons;
+    G4int    nbins[kNumAxes];
+    G4double lo[kNumAxes], hi[kNumAxes], inv_width[kNumAxes];
+
+    std::vector<G4double> injected, detected_u, detected_w;
+    std::vector<G4double> prob_u, prob_w;
+};
+
+#endif /* TS01_AcceptanceTable_h */
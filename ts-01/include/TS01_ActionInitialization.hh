@@ -11,14 +11,27 @@
 
 #include "G4VUserActionInitialization.hh"
 #include "TS01_PrimaryGenerator.hh"
+#include "TS01_RunAction.hh"
+#include "TS01_StackingAction.hh"
+#include "TS01_TrajectoryCapture.hh"
 
 class TS01_ActionInitialization : public G4VUserActionInitialization
 {
 public:
     virtual ~TS01_ActionInitialization() { }
+    virtual void BuildForMaster() const
+    {
+        SetUserAction(new TS01_RunAction);
+    }
     virtual void Build() const
     {
         SetUserAction(new TS01_PrimaryGenerator);
+        SetUserAction(new TS01_RunAction);
+        SetUserAction(new TS01_StackingAction);
+        
+        TS01_TrajectoryCapture* capture = new TS01_TrajectoryCapture;
+        SetUserAction(capture);
+        SetUserAction(new TS01_TrajectoryCapture::Events(capture));
     }
 };
 
@@ -0,0 +1,47 @@
+//
+//  TS01_Bench.hh
+//  ts_01
+//
+//  Benchmark record for --bench-json.  The master run action brackets
+//  every run; at end of run one JSON object per line is appended to the
+//  file with initialisation and run wall time, event, optical photon and
+//  step rates, and the peak resident set size of the process.  The run
+//  starts when the first thread that processes events begins it, so
+//  worker initialisation counts as initialisation.  Photon and step
+//  counts are the work counters of TS01_Run, plus the photons folded
+//  with an acceptance table; the step profiler stays off.
+//
+
+#ifndef TS01_Bench_h
+#define TS01_Bench_h
+
+#include "globals.hh"
+
+class TS01_Run;
+
+class TS01_Bench
+{
+public:
+    // Master only
+    static TS01_Bench* Instance();
+    
+    void SetFile(const G4String& file)   { file_name = file; }
+    void SetLabel(const G4String& label) { bench_label = label; }
+    G4bool IsEnabled() const             { return file_name != ""; }
+    
+    void BeginRun();
+    void BeginThreadRun();          // any thread that processes events
+    void EndRun(const TS01_Run* run);
+    
+private:
+    TS01_Bench();
+    
+    G4String file_name;
+    G4String bench_label;
+    G4double t_start;       // process start (first Instance() call) [s]
+    G4double t_run;         // master start of the current run [s]
+    G4double t_events;      // first thread start of the current run [s]
+    G4double init_time;     // start to the first event loop [s]
+};
+
+#endif /* TS01_Bench_h */
@@ -0,0 +1,82 @@
+//
+//  TS01_CascadeCherenkov.hh
+//  ts_01
+//
+//  Parametrised Cherenkov light of electromagnetic cascades in the ice
+//  (/ts01/cascade/).  An e-, e+ or gamma in the ice above the threshold
+//  energy is stopped at its first step and its cascade replaced by the
+//  Cherenkov photons it would emit, without tracking any secondary:
+//
+//    - light: a total Cherenkov track length L = alpha E^beta of beta = 1
+//      particles, times the Frank-Tamm photons per unit length from the
+//      ice RINDEX; photon energies follow 1 - 1/n(E)^2
+//    - depth along the cascade axis: a gamma distribution in radiation
+//      lengths, t^(a-1) exp(-b t) with a = a0 + a1 ln(E/GeV)
+//    - direction to the axis: a exp(b |cos(theta) - 1/n|^c) + d, with n
+//      taken at the mean photon energy of the Frank-Tamm spectrum rather
+//      than at each photon's own energy; over the ice RINDEX (1.33 to
+//      1.36) that moves the peak by up to about 1 degree at the ends of
+//      the spectrum
+//
+//  (fits to Geant4 cascades in ice by L. Raedel and C. Wiebusch,
+//  Astropart. Phys. 38 (2012) 53, valid above about 1 GeV).  Photons
+//  start on the axis at the speed of light behind the cascade front;
+//  lateral spread is neglected and light past the edge of the world is
+//  dropped.  At most maxPhotons photons are emitted per cascade, as
+//  super-photons of equal weight beyond that.  Photon energies and
+//  angles are inverse-CDF table lookups built for the ice on first use.
+//
+//  Registered for e-, e+ and gamma by TS01_PhysicsList with --cascade;
+//  while disabled it never limits a step, so full EM tracking is
+//  unchanged.  cascade-01.mac validates it against full EM: a run with
+//  parametrised cascades reports its light and hits per event against
+//  those of the last full-EM run (TS01_RunAction).
+//
+
+#ifndef TS01_CascadeCherenkov_h
+#define TS01_CascadeCherenkov_h
+
+#include <vector>
+
+#include "G4VDiscreteProcess.hh"
+
+class G4Material;
+class TS01_CascadeMessenger;
+
+class TS01_CascadeCherenkov : public G4VDiscreteProcess
+{
+public:
+    TS01_CascadeCherenkov(const G4String& name = "TS01Cascade");
+    virtual ~TS01_CascadeCherenkov();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+
+    virtual G4double GetMeanFreePath(const G4Track&, G4double, G4ForceCondition*);
+    virtual G4double PostStepGetPhysicalInteractionLength(const G4Track& track, G4double previous,
+                                                          G4ForceCondition* condition);
+    virtual G4VParticleChange* PostStepDoIt(const G4Track& track, const G4Step& step);
+
+    void SetEnabled(G4bool on)         { enabled = on; }
+    void SetThreshold(G4double e)      { threshold = e; }
+    void SetMaxPhotons(G4int n)        { max_photons = n; }
+
+private:
+    // Tables for the cascade material; false if it has no RINDEX
+    G4bool BuildTables();
+
+    static G4double Lookup(const std::vector<G4double>& table, G4double u);
+
+    G4bool   enabled;
+    G4double threshold;
+    G4int    max_photons;
+
+    const G4Material* ice;
+    G4bool   tables_built;
+    G4double photons_per_length;        // Frank-Tamm, beta = 1
+    std::vector<G4double> energy;       // inverse CDF of the photon energy
+    std::vector<G4double> cos_theta;    // inverse CDF of the angle to the axis
+
+    TS01_CascadeMessenger* messenger;
+};
+
+#endif /* TS01_CascadeCherenkov_h */
@@ -0,0 +1,38 @@
+//
+//  TS01_CascadeMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/cascade/ for TS01_CascadeCherenkov.  With
+//  --cascade the process exists on every thread, and the commands are
+//  broadcast to the workers.
+//
+
+#ifndef TS01_CascadeMessenger_h
+#define TS01_CascadeMessenger_h
+
+#include "G4UImessenger.hh"
+
+class TS01_CascadeCherenkov;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+
+class TS01_CascadeMessenger : public G4UImessenger
+{
+public:
+    TS01_CascadeMessenger(TS01_CascadeCherenkov*);
+    virtual ~TS01_CascadeMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+    TS01_CascadeCherenkov* cascade;
+
+    G4UIdirectory*             cascade_dir;
+    G4UIcmdWithABool*          enable_cmd;
+    G4UIcmdWithADoubleAndUnit* threshold_cmd;
+    G4UIcmdWithAnInteger*      photons_cmd;
+};
+
+#endif /* TS01_CascadeMessenger_h */
@@ -0,0 +1,59 @@
+//
+//  TS01_Cerenkov.hh
+//  ts_01
+//
+//  Cherenkov light folded with a fast acceptance table.  With a table
+//  (/ts01/acceptance/load) the light of a charged step is folded with
+//  the table instead of being emitted: the mean photon count of the step
+//  (Frank-Tamm over the material RINDEX, as G4Cerenkov) times the mean
+//  detection probability of a few photons sampled on the Cherenkov cone
+//  along the step goes straight to TS01_PhotoSD, and no optical photon
+//  track is created.
+//
+//  Registered by TS01_PhysicsList next to the G4OpticalPhysics Cerenkov
+//  process, with its step limits.  Without a table it never acts and
+//  G4Cerenkov emits photons as usual; TS01_StackingAction hands it the
+//  table each event, and while it has one G4Cerenkov is inactivated.
+//
+
+#ifndef TS01_Cerenkov_h
+#define TS01_Cerenkov_h
+
+#include <vector>
+
+#include "G4Cerenkov.hh"
+#include "G4MaterialPropertyVector.hh"
+
+class G4ProcessManager;
+class TS01_AcceptanceTable;
+class TS01_PhotoSD;
+
+class TS01_Cerenkov : public G4Cerenkov
+{
+public:
+    // Configured as original, which it stands in for
+    TS01_Cerenkov(G4Cerenkov* original);
+    virtual ~TS01_Cerenkov() { }
+
+    // Register for a particle that has original
+    void AddTo(G4ProcessManager* pm);
+
+    virtual G4double PostStepGetPhysicalInteractionLength(const G4Track& track, G4double previous,
+                                                          G4ForceCondition* condition);
+    virtual G4VParticleChange* PostStepDoIt(const G4Track& track, const G4Step& step);
+
+    // NULL table: photons are emitted by the original G4Cerenkov
+    void SetAcceptance(const TS01_AcceptanceTable* t, TS01_PhotoSD* sd);
+
+private:
+    // Mean photons per unit length of a particle of charge z (units of
+    // eplus) at speed beta
+    static G4double PhotonsPerLength(const G4MaterialPropertyVector* rindex, G4double z, G4double beta);
+
+    G4Cerenkov* original;
+    std::vector<G4ProcessManager*> managers;
+    const TS01_AcceptanceTable* table;
+    TS01_PhotoSD* photo_sd;
+};
+
+#endif /* TS01_Cerenkov_h */
@@ -0,0 +1,96 @@
+//
+//  TS01_Checkpoint.hh
+//  ts_01
+//
+//  Periodic checkpoints of long runs.  Each thread holds the run results
+//  of the events it has finished (TS01_Run) and their event IDs; every
+//  <events> events or <seconds> seconds a new generation starts: the
+//  threads copy these into their slot as they finish their next event (or
+//  their run), and the last of them rewrites the file once with all
+//  slots, plus everything carried over from a resumed checkpoint and the
+//  runs already completed.  Between generations events only touch
+//  atomic counters.  Since every event is seeded from its own
+//  ID (TS01_Shard) no random engine state needs saving: --resume skips
+//  the events a checkpoint holds, reprocesses the rest, and adds the
+//  checkpointed results at end of run, giving the uninterrupted result.
+//
+//  Binary hit output and the profile are not checkpointed.
+//
+
+#ifndef TS01_Checkpoint_h
+#define TS01_Checkpoint_h
+
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "globals.hh"
+
+class TS01_Run;
+
+class TS01_Checkpoint
+{
+public:
+    static TS01_Checkpoint* Instance();
+
+    // Master only, between runs
+    void   SetFile(const G4String& file) { file_name = file; }
+    void   SetPeriod(G4int events, G4double seconds);
+    G4bool Resume(const G4String& file);
+
+    // Master at start and end of every run; EndRun adds the carried
+    // results into the merged run and rewrites the file
+    void BeginRun(G4int run_id, G4bool enable);
+    void EndRun(TS01_Run* run);
+
+    // Threads that process events
+    G4bool IsDone(G4int event_id) const;
+    void   BeginThreadRun();
+    void   EndOfEvent(G4int event_id, const TS01_Run* run);
+    void   EndThreadRun(const TS01_Run* run);
+
+private:
+    TS01_Checkpoint();
+
+    // Event IDs of a part as sorted, inclusive ranges
+    typedef std::vector<std::pair<G4int, G4int> > Ranges;
+    struct Part
+    {
+        Ranges   done;
+        G4String summary;   // TS01_Run::WriteSummary
+    };
+
+    struct ThreadState
+    {
+        std::vector<G4int> done;
+        G4int    generation;
+    };
+
+    static G4String Serialize(const Part& part);
+    Part MakePart(const ThreadState& state, const TS01_Run* run) const;
+    void UpdateSlot(ThreadState& state, const TS01_Run* run);   // with the lock held
+    void Write() const;
+
+    G4String file_name;
+    G4int    period_events;
+    G4double period_seconds;
+    G4bool   active;
+
+    G4int    run_id;
+    std::map<G4int, std::vector<Part> > resumed;    // by run ID
+    std::vector<Part>   carried;                     // resumed parts of this run
+    Ranges              done;                        // union of carried
+    std::map<G4int, Part> slots;                     // by thread ID
+    G4String            finished;                    // completed runs, serialized
+
+    std::atomic<G4int>    events_since;
+    std::atomic<G4double> last_time;
+    std::atomic<G4int>    generation;
+    G4int    running;                                // threads in the run
+    G4int    waiting;                                // of them, slots behind generation
+
+    static G4ThreadLocal ThreadState* thread_state;
+};
+
+#endif /* TS01_Checkpoint_h */
@@ -2,23 +2,70 @@
 #ifndef TS01_DetectorConstruction_h
 #define TS01_DetectorConstruction_h
 
+#include <iosfwd>
 #include <vector>
+#include <map>
 #include "G4Material.hh"
 #include "G4PVPlacement.hh"
 #include "G4OpticalSurface.hh"
 #include "G4VUserDetectorConstruction.hh"
 
+class TS01_FiberRingParameterisation;
+class TS01_SpectralResponse;
+class TS01_ResponseMessenger;
+
 class TS01_DetectorConstruction : public G4VUserDetectorConstruction
 {
 public:
     TS01_DetectorConstruction(bool, int, G4double, G4double);
     virtual ~TS01_DetectorConstruction();
 	virtual G4VPhysicalVolume* Construct();
+    virtual void ConstructSDandField();
+    
+    G4bool   IsFiber() const           { return doFiber; }
+    G4int    GetNumFiber() const       { return num_fiber; }
+    G4double GetFiberDiameter() const  { return fiber_dia; }
+    G4double GetFiberLength() const    { return fiber_len; }
+    G4double GetDetectorRadius() const { return det_radius; }
+    G4double GetPMTFaceLength() const  { return pmt_face_z; }
+    G4double GetPMTBodyLength() const  { return pmt_body_z; }
+    G4double GetPMTRadius() const      { return 0.6*fiber_dia; }
+    G4double GetDOMRadius() const      { return dom_radius; }
+    G4double GetDOMGlass() const       { return dom_glass; }
+    G4double GetDOMPMTRadius() const   { return dom_pmt_radius; }
+    G4double GetDOMPMTGlass() const    { return dom_pmt_glass; }
+    G4double GetDOMPMTTheta() const    { return dom_pmt_theta; }
+    G4double GetWorldHalfLength() const { return world_half; }
+    
+    // Change the detector for the next geometry (re)initialisation
+    void SetGeometry(bool fiber, int n, G4double dia, G4double r);
+    
+    // Build the fiber ring as one G4PVParameterised instead of per-fiber placements
+    void SetParameterisedRing(bool param) { paramRing = param; }
+    G4bool IsParameterisedRing() const    { return paramRing; }
+    
+    // Put the fibers in FiberRegion with the TS01_FiberLightGuide fast
+    // simulation model; needs G4FastSimulationPhysics for optical photons
+    void SetFiberFastSim(bool fast) { fiberFastSim = fast; }
+    
+    // Spectral responses applied by TS01_PhotoSD, assigned by sensitive
+    // logical volume name; unassigned volumes use "bialkali"
+    TS01_SpectralResponse* GetResponse(const G4String& name, G4bool create = false);
+    void AssignResponse(const G4String& volume, const G4String& response);
+    const TS01_SpectralResponse* GetVolumeResponse(const G4String& volume) const;
+    void ListResponses() const;
+    
+    // The default response and every assignment, exactly
+    void DescribeResponses(std::ostream& os) const;
+    
+    // Envelope of the responses in use: the default and all assigned
+    G4double GetMaxEfficiency() const;
 
 private:
     void ConstructMaterials();
     void ConstructDOM(G4LogicalVolume*);
     void ConstructFibers(G4LogicalVolume*);
+    void ConstructFiberRing(G4LogicalVolume*);
     
     void add_air_optics(void);
     void add_ice_optics(void);
@@ -26,12 +73,20 @@ private:
     void add_wls_optics(void);
     
     G4bool   doFiber;
+    G4bool   paramRing;
+    G4bool   fiberFastSim;
     G4int    num_fiber;
 	G4double fiber_dia;
 	G4double fiber_len;
 	G4double det_radius;
     G4double pmt_face_z;
     G4double pmt_body_z;
+    G4double dom_radius;
+    G4double dom_glass;         // pressure sphere wall
+    G4double dom_pmt_radius;    // R7081 photocathode shell: inner radius,
+    G4double dom_pmt_glass;     //   thickness and
+    G4double dom_pmt_theta;     //   polar angle it starts at
+    G4double world_half;
 	
     G4Material *polystyrene, *pmma, *fp;
     G4Material *vacuum, *air, *ice, *glass, *al;
@@ -50,6 +105,12 @@ private:
     G4VPhysicalVolume *core, *inner;
     
     G4OpticalSurface* photocathode;
+    
+    TS01_FiberRingParameterisation* ring_param;
+    
+    std::vector<TS01_SpectralResponse*>            responses;
+    std::map<G4String, TS01_SpectralResponse*>     volume_response;
+    TS01_ResponseMessenger*                        response_messenger;
 };
 
 	
@@ -0,0 +1,58 @@
+//
+//  TS01_FiberLightGuide.hh
+//  ts_01
+//
+//  Fast simulation of light transport along the WLS fibers.  The model
+//  lives in the FiberRegion (outer cladding as envelope) and takes over
+//  optical photons in the core that are trapped by total internal
+//  reflection at the core/inner cladding wall.  The bounce pattern in a
+//  straight cylinder is known analytically, so the photon is moved to the
+//  fiber end in one step with the group-velocity arrival time, unless the
+//  sampled core absorption or WLS re-absorption comes first.  Photons only
+//  guided by the outer claddings are left to full tracking.
+//
+
+#ifndef TS01_FiberLightGuide_h
+#define TS01_FiberLightGuide_h
+
+#include <vector>
+
+#include "G4VFastSimulationModel.hh"
+#include "G4MaterialPropertyVector.hh"
+
+class G4Region;
+
+class TS01_FiberLightGuide : public G4VFastSimulationModel
+{
+public:
+    TS01_FiberLightGuide(const G4String& name, G4Region* region);
+    virtual ~TS01_FiberLightGuide();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack);
+    virtual void   DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+
+private:
+    // Guided photon in envelope coordinates
+    struct Path
+    {
+        const G4Material* core;
+        G4double core_r;     // core radius
+        G4double length;     // path length to the fiber end
+    };
+
+    // False unless the photon is in the core and guided by the core wall
+    G4bool Trace(const G4FastTrack& fastTrack, Path& path) const;
+
+    // Position and direction after a path length s of specular bounces
+    // inside a cylinder of radius r
+    static void Propagate(G4double r, G4double s, G4ThreeVector& x, G4ThreeVector& u);
+
+    G4double SampleEmission(const G4MaterialPropertyVector* spectrum, G4double e_max);
+
+    // Cumulative WLSCOMPONENT spectrum, rebuilt if the spectrum changes
+    const G4MaterialPropertyVector* emission;
+    std::vector<G4double> emission_cdf;
+};
+
+#endif /* TS01_FiberLightGuide_h */
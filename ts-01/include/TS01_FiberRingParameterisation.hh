@@ -0,0 +1,29 @@
+//
+//  TS01_FiberRingParameterisation.hh
+//  ts_01
+//
+//  Places copy i of a fiber channel at phi = 2 pi i / n on a ring of the
+//  given radius.  The copy number is the channel number read out by
+//  TS01_PhotoSD.
+//
+
+#ifndef TS01_FiberRingParameterisation_h
+#define TS01_FiberRingParameterisation_h
+
+#include "globals.hh"
+#include "G4VPVParameterisation.hh"
+
+class TS01_FiberRingParameterisation : public G4VPVParameterisation
+{
+public:
+    TS01_FiberRingParameterisation(G4double radius, G4int n);
+    virtual ~TS01_FiberRingParameterisation() { }
+    
+    virtual void ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* pv) const;
+    
+private:
+    G4double radius;
+    G4int    num_fiber;
+};
+
+#endif /* TS01_FiberRingParameterisation_h */
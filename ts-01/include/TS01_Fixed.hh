@@ -0,0 +1,70 @@
+//
+//  TS01_Fixed.hh
+//  ts_01
+//
+//  Fixed-point sum with 2^-48 resolution, for the run sums and histogram
+//  bins of TS01_Run.  Terms are rounded once as they are added and the
+//  sum itself is integer, so totals do not depend on the order threads,
+//  sharded jobs or checkpoints are added up in.  The resolution keeps
+//  squared weights of thinned or folded events (1e-6 and below) to 1e-8
+//  or better.  The sum is a 128-bit count of 2^-48, so sums up to 2^78:
+//  a term of 2^64 or more, or a sum that would overflow (only corrupt
+//  weights get there), raises a G4Exception and is not added.
+//  operator<< prints 15 decimals, trailing zeros trimmed, which are
+//  closer to the sum than half its resolution, so operator>> reads them
+//  back to exactly the same sum.
+//
+
+#ifndef TS01_Fixed_h
+#define TS01_Fixed_h
+
+#include <math.h>
+#include <iosfwd>
+
+#include "globals.hh"
+
+class TS01_Fixed
+{
+public:
+    TS01_Fixed() : value(0) { }
+    explicit TS01_Fixed(G4double x) : value(Round(x)) { }
+
+    inline TS01_Fixed& operator+=(G4double x)          { return Add(Round(x)); }
+    inline TS01_Fixed& operator+=(const TS01_Fixed& f) { return Add(f.value); }
+
+    G4bool operator==(const TS01_Fixed& f) const { return value == f.value; }
+    G4bool operator!=(const TS01_Fixed& f) const { return value != f.value; }
+
+    G4double ToDouble() const { return (G4double) value * (1.0 / kOne); }
+
+    friend std::ostream& operator<<(std::ostream& os, const TS01_Fixed& f);
+    friend std::istream& operator>>(std::istream& is, TS01_Fixed& f);
+
+private:
+    __extension__ typedef __int128 Int;
+
+    static const G4int kBits = 48;
+    static constexpr G4double kOne = 281474976710656.0;             // 2^48
+
+    static inline Int Round(G4double x)
+    {
+        const G4double f = nearbyint(x * kOne);
+        return fabs(f) < 5192296858534827628530496329220096.0 ? (Int) f : OutOfRange(x);   // 2^112
+    }
+    static Int OutOfRange(G4double x);
+
+    // Both sides stay below 2^126, so the sum itself cannot overflow
+    inline TS01_Fixed& Add(Int v)
+    {
+        const Int sum = value + v;
+        const Int top = sum >> 126;
+        if (top == 0 || top == -1) value = sum;
+        else Overflow();
+        return *this;
+    }
+    void Overflow() const;
+
+    Int value;
+};
+
+#endif /* TS01_Fixed_h */
@@ -0,0 +1,64 @@
+//
+//  TS01_Histogram.hh
+//  ts_01
+//
+//  Fixed-bin 1D accumulator.  Each thread fills its own copy (held by
+//  TS01_Run); copies with identical binning are summed at end of run.
+//  Bin contents are TS01_Fixed sums, so weighted fills merge to the same
+//  bits in any order.
+//
+
+#ifndef TS01_Histogram_h
+#define TS01_Histogram_h
+
+#include <iosfwd>
+#include <vector>
+
+#include "globals.hh"
+#include "TS01_Fixed.hh"
+
+class TS01_Histogram
+{
+public:
+    TS01_Histogram(const G4String& name = "", G4int nbins = 1, G4double lo = 0.0, G4double hi = 1.0);
+    
+    void SetBinning(G4int nbins, G4double lo, G4double hi);
+    void Reset();
+    
+    // Bin 0 is underflow, bin nbins+1 is overflow
+    inline void Fill(G4double x, G4double w = 1.0)
+    {
+        G4int i;
+        if (x < lo)
+            i = 0;
+        else if (!(x < hi))
+            i = nbins + 1;
+        else
+        {
+            i = 1 + (G4int) ((x - lo) * inv_width);
+            if (i > nbins) i = nbins;
+        }
+        counts[i] += w;
+        entries++;
+    }
+    
+    G4bool Merge(const TS01_Histogram& other);
+    void   Write(std::ostream& os) const;
+    G4bool Read(std::istream& is);      // as written by Write, binning included
+    
+    const G4String& GetName() const { return name; }
+    G4int    GetNbins() const       { return nbins; }
+    G4double GetLow() const         { return lo; }
+    G4double GetHigh() const        { return hi; }
+    G4long   GetEntries() const     { return entries; }
+    G4double GetBinContent(G4int i) const { return counts[i].ToDouble(); }
+    
+private:
+    G4String name;
+    G4int    nbins;
+    G4double lo, hi, inv_width;
+    G4long   entries;
+    std::vector<TS01_Fixed> counts;
+};
+
+#endif /* TS01_Histogram_h */
@@ -0,0 +1,89 @@
+//
+//  TS01_HitWriter.hh
+//  ts_01
+//
+//  Thread-local photon hit output.  Hits are written as fixed-size binary
+//  records through a large in-memory buffer; each run starts a new block
+//  with a TS01_HitFileHeader whose n_records field is filled in at end of
+//  run.  The old "SD-S <time> <wl>" text lines can be echoed for debugging.
+//
+
+#ifndef TS01_HitWriter_h
+#define TS01_HitWriter_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "globals.hh"
+
+struct TS01_HitFileHeader
+{
+    char     magic[8];      // "TS01HIT"
+    uint32_t version;
+    uint32_t record_size;   // sizeof(TS01_HitRecord)
+    int32_t  fiber_mode;    // 0 = DOM, 1 = fiber ring (-D/-F)
+    int32_t  num_fiber;     // -n
+    double   fiber_dia;     // -d [mm]
+    double   det_radius;    // -r [cm]
+    int32_t  run_id;
+    int32_t  thread_id;     // -1 for sequential runs
+    uint64_t n_records;
+};
+
+struct TS01_HitRecord
+{
+    int32_t event;
+    int32_t channel;        // copy number of the sensitive volume
+    float   time;           // global time [ns]
+    float   wavelength;     // [nm]
+    float   pos[3];         // global position [mm]
+    float   dir[3];         // momentum direction
+    float   weight;         // track weight, 1 unless thinned (/ts01/thin/)
+};
+
+class TS01_HitWriter
+{
+public:
+    static const uint32_t version = 2;
+    
+    // One writer per thread
+    static TS01_HitWriter* Instance();
+    
+    ~TS01_HitWriter();
+    
+    void Open(const G4String& file_name);
+    void Close();
+    void BeginRun(const TS01_HitFileHeader& header);
+    void EndRun();
+    
+    void SetTextEcho(G4bool echo) { text_echo = echo; }
+    G4bool IsActive() const { return fp != NULL || text_echo; }
+    
+    inline void Write(const TS01_HitRecord& r)
+    {
+        if (text_echo)
+            G4cout << "SD-S " << r.time << " " << r.wavelength << G4endl;
+        if (fp == NULL) return;
+        if (fill + sizeof(r) > buffer.size()) Flush();
+        memcpy(&buffer[fill], &r, sizeof(r));
+        fill += sizeof(r);
+        n_records++;
+    }
+    
+private:
+    TS01_HitWriter();
+    void Flush();
+    
+    FILE*             fp;
+    G4String          name;
+    std::vector<char> buffer;
+    size_t            fill;
+    long              header_offset;
+    TS01_HitFileHeader header;
+    uint64_t          n_records;
+    G4bool            text_echo;
+};
+
+#endif /* TS01_HitWriter_h */
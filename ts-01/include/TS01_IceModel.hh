@@ -0,0 +1,100 @@
+//
+//  TS01_IceModel.hh
+//  ts_01
+//
+//  Layered ice for TS01_OpLayeredIce (--ice-model <file>).  The ice is
+//  cut into horizontal layers of equal thickness, each with its own
+//  effective scattering and absorption coefficients at 400 nm, scaled to
+//  other wavelengths as (wl/400 nm)^-alpha and (wl/400 nm)^-kappa.
+//  Scattering angles follow Henyey-Greenstein with mean cosine g, so the
+//  geometric scattering coefficient is b_e / (1 - g).
+//
+//  File format, '#' starts a comment:
+//
+//      g      0.9
+//      alpha  0.898
+//      kappa  1.084
+//      layers <z of the lowest layer's bottom [m]> <thickness [m]>
+//      <b_e(400) [1/m]> <a(400) [1/m]>     one line per layer, lowest first
+//
+//  Photons above or below the layers get the nearest layer.  Layer,
+//  wavelength scale and scattering angle are all table lookups: the
+//  layer index from the height, the scales on a uniform energy grid and
+//  cos(theta) from a uniform grid of the HG inverse CDF.  Loaded by the
+//  master before initialisation and read-only afterwards.
+//
+
+#ifndef TS01_IceModel_h
+#define TS01_IceModel_h
+
+#include <algorithm>
+#include <iosfwd>
+#include <vector>
+
+#include "globals.hh"
+#include "TS01_OpticalCache.hh"
+
+class G4Material;
+
+class TS01_IceModel
+{
+public:
+    static TS01_IceModel* Instance();
+
+    G4bool Load(const G4String& file);
+    G4bool IsLoaded() const { return !scattering.empty(); }
+
+    // The material the layers apply to, set once the materials exist
+    void SetMaterial(const G4Material* m) { material = IsLoaded() ? m : NULL; }
+    const G4Material* GetMaterial() const { return material; }
+
+    // Layer containing height z, clamped to the outermost layers
+    inline G4int Layer(G4double z) const
+    {
+        return (G4int) std::min(std::max((z - z0) * inv_dz, 0.0), top_layer);
+    }
+    G4int    GetNumberOfLayers() const { return scattering.size(); }
+
+    // Every parameter of the model exactly, or "none" when not loaded
+    void Describe(std::ostream& os) const;
+    G4double GetLayerBottom(G4int i) const { return z0 + i / inv_dz; }
+
+    // Geometric scattering and absorption coefficients [1/length] of a
+    // layer at photon energy e
+    inline G4double GetScattering(G4int layer, G4double e) const
+    {
+        return scattering[layer] * scattering_scale.Value(e);
+    }
+    inline G4double GetAbsorption(G4int layer, G4double e) const
+    {
+        return absorption[layer] * absorption_scale.Value(e);
+    }
+
+    // cos(theta) of a scattering for a uniform number u in [0, 1)
+    inline G4double SampleCosTheta(G4double u) const
+    {
+        const G4double f = u * kAngleBins;
+        const G4int    j = (G4int) f;
+        const G4double w = f - j;
+        return cos_theta[j] + w*(cos_theta[j+1] - cos_theta[j]);
+    }
+
+private:
+    TS01_IceModel();
+
+    static const G4int kAngleBins = 4096;
+    static const G4int kEnergyBins = 1024;
+
+    const G4Material* material;
+    G4double g, alpha, kappa;
+
+    G4double z0, inv_dz, top_layer;
+    std::vector<G4double> scattering;       // b_e / (1 - g) at 400 nm, by layer
+    std::vector<G4double> absorption;       // a at 400 nm, by layer
+
+    TS01_OpticalTable scattering_scale;     // (wl/400 nm)^-alpha
+    TS01_OpticalTable absorption_scale;     // (wl/400 nm)^-kappa
+    std::vector<G4double> cos_theta;        // HG inverse CDF, kAngleBins+1 points and a copy
+};
+
+#endif /* TS01_IceModel_h */
@@ -0,0 +1,33 @@
+//
+//  TS01_OpAbsorption.hh
+//  ts_01
+//
+//  G4OpAbsorption with the absorption length taken from the uniform-grid
+//  TS01_OpticalCache instead of the material's ABSLENGTH vector
+//  (--optics-cache), and none in the layered ice of TS01_IceModel, where
+//  TS01_OpLayeredIce absorbs.  Registered in place of OpAbsorption by
+//  TS01_PhysicsList with --optics-cache or --ice-model.
+//
+
+#ifndef TS01_OpAbsorption_h
+#define TS01_OpAbsorption_h
+
+#include "G4OpAbsorption.hh"
+
+class TS01_OpticalCache;
+class TS01_IceModel;
+
+class TS01_OpAbsorption : public G4OpAbsorption
+{
+public:
+    TS01_OpAbsorption(const G4String& name = "TS01_OpAbsorption");
+    virtual ~TS01_OpAbsorption() { }
+
+    virtual G4double GetMeanFreePath(const G4Track& track, G4double, G4ForceCondition*);
+
+private:
+    const TS01_OpticalCache* cache;     // NULL without --optics-cache
+    const TS01_IceModel*     ice_model;
+};
+
+#endif /* TS01_OpAbsorption_h */
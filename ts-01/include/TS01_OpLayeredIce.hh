@@ -0,0 +1,46 @@
+//
+//  TS01_OpLayeredIce.hh
+//  ts_01
+//
+//  Scattering and absorption of optical photons in the layered ice of
+//  TS01_IceModel, as one discrete process: the free path is sampled in
+//  optical depths and used up layer by layer, steps being limited at
+//  layer boundaries, and at the end of it the photon is absorbed with
+//  probability a / (a + b) or otherwise scattered with a tabulated HG
+//  angle.  TS01_OpAbsorption leaves the ice to this process.
+//  Registered by TS01_PhysicsList with --ice-model.
+//
+
+#ifndef TS01_OpLayeredIce_h
+#define TS01_OpLayeredIce_h
+
+#include "G4VDiscreteProcess.hh"
+
+class TS01_IceModel;
+class G4Material;
+
+class TS01_OpLayeredIce : public G4VDiscreteProcess
+{
+public:
+    TS01_OpLayeredIce(const G4String& name = "TS01_OpLayeredIce");
+    virtual ~TS01_OpLayeredIce() { }
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+    virtual void   StartTracking(G4Track* track);
+
+    virtual G4double GetMeanFreePath(const G4Track& track, G4double, G4ForceCondition*);
+    virtual G4double PostStepGetPhysicalInteractionLength(const G4Track& track, G4double previous,
+                                                          G4ForceCondition* condition);
+    virtual G4VParticleChange* PostStepDoIt(const G4Track& track, const G4Step& step);
+
+private:
+    const TS01_IceModel* model;
+
+    // State of the current track on this thread
+    G4double optical_depth;     // left to the next interaction, < 0 to sample
+    G4double step_mfp;          // mean free path over the last step, 0 outside the ice
+    G4bool   at_layer;          // last step was limited by a layer boundary
+    G4double scattering, absorption;
+};
+
+#endif /* TS01_OpLayeredIce_h */
@@ -0,0 +1,30 @@
+//
+//  TS01_OpWLS.hh
+//  ts_01
+//
+//  G4OpWLS with the absorption length taken from the uniform-grid
+//  TS01_OpticalCache instead of the material's WLSABSLENGTH vector;
+//  re-emission is unchanged.  Registered in place of OpWLS by
+//  TS01_PhysicsList with --optics-cache.
+//
+
+#ifndef TS01_OpWLS_h
+#define TS01_OpWLS_h
+
+#include "G4OpWLS.hh"
+
+class TS01_OpticalCache;
+
+class TS01_OpWLS : public G4OpWLS
+{
+public:
+    TS01_OpWLS(const G4String& name = "TS01_OpWLS");
+    virtual ~TS01_OpWLS() { }
+
+    virtual G4double GetMeanFreePath(const G4Track& track, G4double, G4ForceCondition*);
+
+private:
+    const TS01_OpticalCache* cache;
+};
+
+#endif /* TS01_OpWLS_h */
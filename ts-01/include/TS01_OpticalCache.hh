@@ -0,0 +1,99 @@
+//
+//  TS01_OpticalCache.hh
+//  ts_01
+//
+//  RINDEX, ABSLENGTH and WLSABSLENGTH of every material resampled onto a
+//  uniform energy grid once the materials exist, for lookups in constant
+//  time without a bin search or a branch.  Geant4 property vectors search
+//  for the bin (or hit their last-bin cache) and evaluate the spline at
+//  every call; TS01_OpAbsorption and TS01_OpWLS take their mean free
+//  paths from here instead (--optics-cache).
+//
+//  The grid has at least kMinBins bins and a whole number of bins per
+//  table interval, so linear tables on uniform energy points are
+//  reproduced exactly; for spline tables /ts01/optics/list reports the
+//  largest relative deviation from Geant4.  Tables are read-only once
+//  built and shared by all threads.
+//
+
+#ifndef TS01_OpticalCache_h
+#define TS01_OpticalCache_h
+
+#include <algorithm>
+#include <vector>
+
+#include "G4MaterialPropertyVector.hh"
+#include "globals.hh"
+
+class TS01_OpticsMessenger;
+
+class TS01_OpticalTable
+{
+public:
+    TS01_OpticalTable() : e0(0.0), inv_de(0.0), top(0.0), deviation(0.0) { }
+
+    void   Fill(const G4MaterialPropertyVector* mpv, G4int min_bins);
+    
+    // values on values.size()-1 uniform bins from e_low to e_high
+    void   Fill(G4double e_low, G4double e_high, const std::vector<G4double>& values);
+    G4bool IsFilled() const { return !v.empty(); }
+
+    // Photons outside the table range get the end values, as in Geant4
+    inline G4double Value(G4double e) const
+    {
+        const G4double f = std::min(std::max((e - e0) * inv_de, 0.0), top);
+        const G4int    j = (G4int) f;
+        const G4double w = f - j;
+        return v[j] + w*(v[j+1] - v[j]);
+    }
+
+    G4double GetLowEnergy() const   { return e0; }
+    G4double GetHighEnergy() const  { return e0 + top / inv_de; }
+    G4int    GetBins() const        { return (G4int) top; }
+    G4double GetDeviation() const   { return deviation; }
+
+private:
+    G4double e0, inv_de, top;
+    G4double deviation;             // largest relative deviation at bin centres
+    std::vector<G4double> v;        // top+1 grid points, the last one repeated
+};
+
+class TS01_OpticalCache
+{
+public:
+    enum { kRindex, kAbsLength, kWLSAbsLength, kNumProperties };
+
+    static TS01_OpticalCache* Instance();
+
+    // Master only: use the cached mean free paths (TS01_PhysicsList)
+    void   SetEnabled(G4bool on) { enabled = on; }
+    G4bool IsEnabled() const     { return enabled; }
+
+    // Master, once the material property tables are complete
+    void Build();
+
+    // NULL if the material has no such property
+    inline const TS01_OpticalTable* Get(size_t material, G4int property) const
+    {
+        const size_t i = material * kNumProperties + property;
+        return i < tables.size() && tables[i].IsFilled() ? &tables[i] : NULL;
+    }
+
+    void List() const;
+
+    // Time n lookups at random energies through the Geant4 property
+    // vectors and through the cache, for every cached table
+    void Benchmark(G4int n) const;
+
+private:
+    TS01_OpticalCache();
+
+    static const G4int kMinBins = 1024;
+    static const char* PropertyName(G4int property);
+
+    G4bool enabled;
+    std::vector<TS01_OpticalTable> tables;  // material index x kNumProperties
+    TS01_OpticsMessenger* messenger;
+};
+
+#endif /* TS01_OpticalCache_h */
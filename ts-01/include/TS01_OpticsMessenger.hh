@@ -0,0 +1,35 @@
+//
+//  TS01_OpticsMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/optics/ for the shared TS01_OpticalCache.
+//  The cache is built by the master, so the commands are not broadcast.
+//
+
+#ifndef TS01_OpticsMessenger_h
+#define TS01_OpticsMessenger_h
+
+#include "G4UImessenger.hh"
+
+class TS01_OpticalCache;
+class G4UIdirectory;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+class TS01_OpticsMessenger : public G4UImessenger
+{
+public:
+    TS01_OpticsMessenger(TS01_OpticalCache*);
+    virtual ~TS01_OpticsMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+    TS01_OpticalCache* cache;
+
+    G4UIdirectory*           optics_dir;
+    G4UIcmdWithoutParameter* list_cmd;
+    G4UIcmdWithAnInteger*    bench_cmd;
+};
+
+#endif /* TS01_OpticsMessenger_h */
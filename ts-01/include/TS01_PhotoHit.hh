@@ -0,0 +1,66 @@
+//
+//  TS01_PhotoHit.hh
+//  ts_01
+//
+//  One hit per readout channel and event: detected photons (summed track
+//  weights), their response-weighted sum and the first arrival time.  Hits come from a
+//  thread-local G4Allocator pool, so filling the collection does not touch
+//  the heap once the pool has grown to the busiest event.
+//
+
+#ifndef TS01_PhotoHit_h
+#define TS01_PhotoHit_h
+
+#include <float.h>
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+
+class TS01_PhotoHit : public G4VHit
+{
+public:
+    TS01_PhotoHit(G4int ch) :
+        channel(ch), photons(0.0), weighted(0.0), first_time(DBL_MAX) { }
+    virtual ~TS01_PhotoHit() { }
+
+    inline void* operator new(size_t);
+    inline void  operator delete(void*);
+
+    virtual void Print();
+
+    inline void AddPhoton(G4double time, G4double w = 1.0)
+    {
+        photons += w;
+        if (time < first_time) first_time = time;
+    }
+    inline void AddWeight(G4double w) { weighted += w; }
+
+    G4int    GetChannel() const   { return channel; }
+    G4double GetPhotons() const   { return photons; }
+    G4double GetWeighted() const  { return weighted; }
+    G4double GetFirstTime() const { return first_time; }
+
+private:
+    G4int    channel;
+    G4double photons;
+    G4double weighted;
+    G4double first_time;
+};
+
+typedef G4THitsCollection<TS01_PhotoHit> TS01_PhotoHitsCollection;
+
+extern G4ThreadLocal G4Allocator<TS01_PhotoHit>* TS01_PhotoHitAllocator;
+
+inline void* TS01_PhotoHit::operator new(size_t)
+{
+    if (TS01_PhotoHitAllocator == NULL) TS01_PhotoHitAllocator = new G4Allocator<TS01_PhotoHit>;
+    return (void*) TS01_PhotoHitAllocator->MallocSingle();
+}
+
+inline void TS01_PhotoHit::operator delete(void* hit)
+{
+    TS01_PhotoHitAllocator->FreeSingle((TS01_PhotoHit*) hit);
+}
+
+#endif /* TS01_PhotoHit_h */
@@ -9,7 +9,17 @@
 #ifndef TS01_PhotoSD_h
 #define TS01_PhotoSD_h
 
+#include <vector>
+
+#include "G4Track.hh"
 #include "G4VSensitiveDetector.hh"
+#include "G4VUserTrackInformation.hh"
+#include "TS01_PhotoHit.hh"
+
+class TS01_Run;
+class TS01_StackingAction;
+class TS01_SpectralResponse;
+class G4LogicalVolume;
 
 class TS01_PhotoSD : public G4VSensitiveDetector
 {
@@ -22,9 +32,57 @@ public:
     virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history);
     virtual void   EndOfEvent(G4HCofThisEvent* hitCollection);
     
+    // Expected hits from photons that were not tracked (acceptance table fast mode)
+    void AddExpected(G4double unweighted, G4double weighted);
+    
+    // Touchable depth whose copy number is the readout channel
+    void SetChannelDepth(G4int depth) { channel_depth = depth; }
+    
+    // Information of a track that made a hit, for TS01_TrajectoryCapture
+    class Detected : public G4VUserTrackInformation
+    {
+    public:
+        static G4bool Is(const G4Track* track)
+        {
+            return dynamic_cast<const Detected*>(track->GetUserInformation()) != NULL;
+        }
+    };
+    
 private:
+    // Hit of a readout channel, created on its first photon in the event
+    inline TS01_PhotoHit* Hit(G4int channel)
+    {
+        if (channel >= (G4int) channel_hit.size()) channel_hit.resize(channel + 1, -1);
+        G4int& i = channel_hit[channel];
+        if (i < 0) i = hits->insert(new TS01_PhotoHit(channel)) - 1;
+        return (*hits)[i];
+    }
+    
     G4double unweighted_hits, weighted_hits;
-
+    G4int    event_id;
+    G4int    channel_depth;
+    TS01_Run* run;
+    const TS01_StackingAction* stacking;
+    
+    // Hits of this event per sensitive volume, weighted with the volume's
+    // response in one pass at end of event
+    struct HitBuffer
+    {
+        const G4LogicalVolume*       volume;
+        const TS01_SpectralResponse* response;
+        std::vector<G4double>        wl;
+        std::vector<G4int>           channel;
+        std::vector<G4double>        track_weight;
+    };
+    HitBuffer& Buffer(const G4LogicalVolume* volume);
+    
+    std::vector<HitBuffer> buffers;     // kept between events for their capacity
+    size_t                 n_buffers;
+    std::vector<G4double>  weights;
+    
+    TS01_PhotoHitsCollection* hits;
+    G4int                     hc_id;
+    std::vector<G4int>        channel_hit;  // channel -> index in hits, -1 if none
 };
 
 #endif /* TS01_PhotoSD_h */
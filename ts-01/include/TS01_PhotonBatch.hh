@@ -0,0 +1,82 @@
+//
+//  TS01_PhotonBatch.hh
+//  ts_01
+//
+//  Optical photons of one event taken off the stack for sub-event
+//  processing, stored as structure-of-arrays.  Propagate() moves photons
+//  born in the ice straight to the sensor bounding volume, sampling
+//  absorption on the way (the ice has no scattering tables); Fold() sums
+//  acceptance-table probabilities.  Both work on a range of photons and
+//  are safe to run concurrently on disjoint ranges.
+//
+//  The propagation kernel is a few branch-free passes over the arrays
+//  (bounding-volume distance, table lookups on a uniform energy grid,
+//  absorption test and move) that the compiler can vectorise.  Random
+//  numbers come from a counter-based stream keyed by the event and the
+//  photon's track ID, so results do not depend on how the batch is split
+//  or which thread runs a range.
+//
+
+#ifndef TS01_PhotonBatch_h
+#define TS01_PhotonBatch_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4Track;
+class G4VProcess;
+class TS01_SensorBounds;
+class TS01_AcceptanceTable;
+
+class TS01_PhotonBatch
+{
+public:
+    TS01_PhotonBatch();
+    
+    // Resample the ice absorption length and group velocity onto a uniform
+    // energy grid; Geant4 property vectors cache their last bin and cannot
+    // be shared between threads.  Geant4 thread only.
+    G4bool LoadIce();
+    G4bool IsIceLoaded() const { return !ice_abs.empty(); }
+    
+    void   Clear();
+    void   Add(const G4Track* track);
+    size_t Size() const             { return energy.size(); }
+    void   SetEventKey(uint64_t k)  { event_key = k; }
+    
+    void Propagate(size_t begin, size_t end, const TS01_SensorBounds& bounds);
+    void Fold(size_t begin, size_t end, const TS01_AcceptanceTable& table,
+              G4double& unweighted, G4double& weighted) const;
+    
+    // New track for a photon that survived Propagate(), with its original
+    // track ID; the stack takes ownership
+    G4Track* MakeTrack(size_t i) const;
+    G4bool   IsAlive(size_t i) const { return alive[i] != 0; }
+    
+private:
+    static const G4int kIceBins = 256;
+    
+    uint64_t event_key;
+    
+    // Photon arrays, one entry per photon
+    std::vector<G4double> x, y, z;
+    std::vector<G4double> ux, uy, uz;
+    std::vector<G4double> px, py, pz;       // polarisation
+    std::vector<G4double> energy, time, weight;
+    std::vector<G4int>    track_id, parent_id;
+    std::vector<const G4VProcess*> creator;
+    std::vector<G4int>    alive;
+    std::vector<G4double> dist;             // scratch: distance to the sensors
+    std::vector<G4double> path;             // scratch: sampled free path
+    std::vector<G4double> inv_v;            // scratch: 1 / group velocity
+    
+    // Ice tables on kIceBins+1 uniform energy points from ice_e0
+    G4double ice_e0, ice_inv_de;
+    std::vector<G4double> ice_abs;
+    std::vector<G4double> ice_inv_groupvel;
+};
+
+#endif /* TS01_PhotonBatch_h */
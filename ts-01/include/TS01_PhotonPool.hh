@@ -0,0 +1,81 @@
+//
+//  TS01_PhotonPool.hh
+//  ts_01
+//
+//  Process-wide work-stealing thread pool for sub-event photon tasks.
+//  Run() spreads the tasks of one job over per-thread deques; each pool
+//  thread pops its own deque from the back and steals from the front of
+//  the others, and the submitting Geant4 thread works on its own job
+//  until every task has finished, sleeping while there is nothing left
+//  to take.  Several Geant4 workers may submit at
+//  the same time.  Tasks must only touch their own slice of the data:
+//  results then do not depend on which thread ran which task.
+//
+
+#ifndef TS01_PhotonPool_h
+#define TS01_PhotonPool_h
+
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+#include "globals.hh"
+
+class TS01_PhotonPool
+{
+public:
+    typedef std::function<void(size_t)> Task;
+    
+    // Number of pool threads, taken when the pool is first used; 0 runs
+    // every task on the submitting thread.  By default the cores not
+    // taken by Geant4 worker threads.
+    static void SetNumberOfThreads(G4int n);
+    static TS01_PhotonPool* Instance();
+    
+    ~TS01_PhotonPool();
+    
+    // Calls task(i) for i = 0 .. n_tasks-1 and returns when all are done
+    void Run(size_t n_tasks, const Task& task);
+    
+    G4int GetNumberOfThreads() const { return threads.size(); }
+    
+private:
+    struct Job
+    {
+        const Task*         task;
+        std::atomic<size_t> pending;
+    };
+    struct Item
+    {
+        Job*   job;
+        size_t index;
+    };
+    struct Queue
+    {
+        std::mutex       lock;
+        std::deque<Item> items;
+    };
+    
+    TS01_PhotonPool(G4int n);
+    static G4int DefaultThreads();
+    
+    G4bool Take(size_t self, Item& item);   // own back first, then steal fronts
+    void   Execute(const Item& item);
+    void   Work(size_t self);
+    
+    std::vector<Queue*>      queues;        // one per pool thread, plus one for submitters
+    std::vector<std::thread> threads;
+    std::atomic<long>        queued;
+    std::mutex               wake_lock;
+    std::condition_variable  wake;          // pool threads: tasks queued
+    std::condition_variable  done;          // submitters: a job finished or tasks queued
+    G4bool                   stop;
+    
+    static G4int num_threads;
+};
+
+#endif /* TS01_PhotonPool_h */
@@ -4,12 +4,39 @@
 
 #include "G4VModularPhysicsList.hh"
 
+class G4VProcess;
+
 class TS01_PhysicsList : public G4VModularPhysicsList
 {
 public:
     TS01_PhysicsList();
     virtual ~TS01_PhysicsList() { }
     virtual void SetCuts();
-   
+    virtual void ConstructProcess();
+    
+    // Physics table cache: tables are retrieved from <dir>/<key> when an
+    // entry for the current material set and cuts exists, otherwise they
+    // are stored there once built.
+    void SetPhysicsCache(const G4String& dir) { cache_dir = dir; }
+    void StorePhysicsCache();
+    
+    // Register the fast simulation process for optical photons
+    void EnableFastSimulation();
+    
+    // Register TS01_CascadeCherenkov for e-, e+ and gamma, switched on
+    // and off with /ts01/cascade/enable; without it the process tables
+    // are those of full EM
+    void EnableCascade() { cascade = true; }
+    
+private:
+    G4String CacheDescription() const;
+    void     ReplaceOpticalProcess(const G4String& name, G4VProcess* process);
+    void     AddCerenkovFold();
+    
+    G4String cache_dir;
+    G4String cache_entry;
+    G4bool   cache_retrieve;
+    G4bool   cache_pending;
+    G4bool   cascade;
 };
 #endif // TS01_PhysicsList_h
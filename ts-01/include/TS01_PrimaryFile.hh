@@ -0,0 +1,92 @@
+//
+//  TS01_PrimaryFile.hh
+//  ts_01
+//
+//  Pre-generated primaries.  A file is a TS01_PrimaryFileHeader followed
+//  by fixed-size records, the primaries of one event stored contiguously.
+//  Files are written by TS01_PrimaryGenerator in record mode from the GPS
+//  configuration of a macro, and read back through a read-only mmap so
+//  replay costs no parsing and threads share the pages.  Workers append
+//  events in the order they finish, so the reader orders the stored
+//  events by the run and event they were generated in.
+//
+
+#ifndef TS01_PrimaryFile_h
+#define TS01_PrimaryFile_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "globals.hh"
+
+class G4Event;
+
+struct TS01_PrimaryFileHeader
+{
+    char     magic[8];      // "TS01PRI"
+    uint32_t version;
+    uint32_t record_size;   // sizeof(TS01_PrimaryRecord)
+};
+
+struct TS01_PrimaryRecord
+{
+    int32_t run;            // run and event the primary was generated in
+    int32_t event;
+    int32_t pdg;            // PDG encoding (-22 for optical photons)
+    float   pos[3];         // vertex [mm]
+    float   dir[3];         // momentum direction
+    float   pol[3];         // polarisation
+    float   energy;         // kinetic energy [MeV]
+    float   time;           // vertex time [ns]
+    float   weight;
+};
+
+class TS01_PrimaryFile
+{
+public:
+    static const uint32_t version = 2;
+    
+    TS01_PrimaryFile();
+    ~TS01_PrimaryFile();
+    
+    // Reading
+    G4bool Open(const G4String& file_name);
+    void   Close();
+    G4bool IsOpen() const          { return records != NULL; }
+    G4int  GetNumberOfEvents() const { return blocks.size(); }
+    
+    // Primaries of stored event i modulo the number of stored events, in
+    // (run, event) order: event i of a single recorded run replays event i
+    void   Fill(G4int i, G4Event* evt) const;
+    
+    // Writing, shared by all threads; every event is appended in one piece.
+    // Opening the file that is already open is a no-op, so every worker
+    // can execute the broadcast command
+    static G4bool OpenOutput(const G4String& file_name);
+    static void   CloseOutput();
+    static void   FlushOutput();
+    static void   Write(const G4Event* evt, G4int run_id);
+    
+private:
+    struct Block
+    {
+        int32_t run, event;
+        size_t  begin, end;         // records of one stored event
+        G4bool operator<(const Block& b) const
+        {
+            return run != b.run ? run < b.run : event < b.event;
+        }
+    };
+    
+    void*  map;
+    size_t map_size;
+    const TS01_PrimaryRecord* records;
+    std::vector<Block> blocks;      // stored events in (run, event) order
+    G4String name;
+    
+    static FILE*    output;
+    static G4String output_name;
+};
+
+#endif /* TS01_PrimaryFile_h */
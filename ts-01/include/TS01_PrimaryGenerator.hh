@@ -1,9 +1,12 @@
-
 #ifndef TS01_PrimaryGenerator_h
 #define TS01_PrimaryGenerator_h
 
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4GeneralParticleSource.hh"
+#include "TS01_PrimaryFile.hh"
+
+class TS01_AcceptanceTable;
+class TS01_PrimaryMessenger;
 
 class TS01_PrimaryGenerator : public G4VUserPrimaryGeneratorAction
 {
@@ -13,7 +16,27 @@ public:
 
 	virtual void GeneratePrimaries(G4Event*);
 
+    // Replay primaries from a file written in record mode ("" for GPS)
+    void SetReplayFile(const G4String& file);
+    
+    // Record mode: append every event's primaries to a shared file; with
+    // record_only the stacking action kills all tracks
+    void SetRecordFile(const G4String& file, G4bool only);
+    static G4bool IsRecordOnly() { return record_only; }
+    
+    // 0: quiet, 1: one line per event, 2: G4Event::Print()
+    void SetVerbose(G4int level) { verbose = level; }
+
 private:
+    // Acceptance table build mode: photons into the event's table bin
+    void InjectPhotons(G4Event*, const TS01_AcceptanceTable&);
+    void PrintSummary(const G4Event*) const;
+
 	G4GeneralParticleSource *src;
+    TS01_PrimaryMessenger*   messenger;
+    TS01_PrimaryFile         replay;
+    G4int                    verbose;
+    
+    static G4bool record_only;
 };
 #endif
@@ -0,0 +1,38 @@
+//
+//  TS01_PrimaryMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/primary/.  Replay files are mapped by every
+//  generator, so replay and verbosity are broadcast; the record file is
+//  shared by all threads and opened once on the master.
+//
+
+#ifndef TS01_PrimaryMessenger_h
+#define TS01_PrimaryMessenger_h
+
+#include "G4UImessenger.hh"
+
+class TS01_PrimaryGenerator;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+
+class TS01_PrimaryMessenger : public G4UImessenger
+{
+public:
+    TS01_PrimaryMessenger(TS01_PrimaryGenerator*);
+    virtual ~TS01_PrimaryMessenger();
+    
+    virtual void SetNewValue(G4UIcommand*, G4String);
+    
+private:
+    TS01_PrimaryGenerator* generator;
+    
+    G4UIdirectory*        primary_dir;
+    G4UIcmdWithAString*   replay_cmd;
+    G4UIcommand*          record_cmd;
+    G4UIcmdWithAnInteger* verbose_cmd;
+};
+
+#endif /* TS01_PrimaryMessenger_h */
@@ -0,0 +1,64 @@
+//
+//  TS01_Profile.hh
+//  ts_01
+//
+//  Step, track and sampled wall-time counters per logical volume, per
+//  process and per particle type, filled by TS01_Profiler and merged
+//  with the run.  Entries are looked up by object address on the thread
+//  that fills them (with a one-entry cache, since consecutive steps are
+//  mostly in the same volume) and matched by name when merging.
+//
+
+#ifndef TS01_Profile_h
+#define TS01_Profile_h
+
+#include <vector>
+
+#include "globals.hh"
+
+class TS01_Profile
+{
+public:
+    enum { kVolume, kProcess, kParticle, kNumTables };
+    
+    struct Entry
+    {
+        const void* key;    // identity on the filling thread, NULL once merged
+        G4String    name;
+        G4long      steps;
+        G4long      tracks;
+        G4double    time;   // sampled wall time scaled by the sampling period [s]
+    };
+    
+    TS01_Profile();
+    
+    inline Entry* Find(G4int table, const void* key)
+    {
+        std::vector<Entry>& v = tables[table];
+        if (last[table] < v.size() && v[last[table]].key == key) return &v[last[table]];
+        for (size_t i=0; i<v.size(); i++)
+        {
+            if (v[i].key != key) continue;
+            last[table] = i;
+            return &v[i];
+        }
+        return NULL;
+    }
+    Entry* Add(G4int table, const void* key, const G4String& name);
+    
+    void   Merge(const TS01_Profile& other);
+    G4bool IsEmpty() const { return tables[kVolume].empty() && tables[kParticle].empty(); }
+    
+    // Totals over a table, or for the entry of that name
+    G4long GetSteps(G4int table) const;
+    G4long GetTracks(G4int table, const G4String& name) const;
+    
+    // Ranked by time, or by steps if no time was sampled; top rows per table
+    void   Print(G4int top) const;
+    
+private:
+    std::vector<Entry> tables[kNumTables];
+    size_t             last[kNumTables];
+};
+
+#endif /* TS01_Profile_h */
@@ -0,0 +1,70 @@
+//
+//  TS01_Profiler.hh
+//  ts_01
+//
+//  Stepping and tracking actions that fill the TS01_Profile of the
+//  current run.  They are only installed on a thread once profiling is
+//  first enabled (/ts01/profile/enable), so runs that never profile pay
+//  nothing; disabling afterwards leaves a single flag test per step.
+//
+//  Every step and track is counted.  Wall time is sampled: every
+//  <period>-th step the clock is read at its end and the duration of the
+//  following step, scaled by the period, is charged to that step's
+//  volume, process and particle.
+//
+
+#ifndef TS01_Profiler_h
+#define TS01_Profiler_h
+
+#include "G4UserSteppingAction.hh"
+#include "G4UserTrackingAction.hh"
+#include "globals.hh"
+
+class TS01_Profile;
+
+class TS01_Profiler : public G4UserSteppingAction
+{
+public:
+    TS01_Profiler();
+    virtual ~TS01_Profiler() { }
+    
+    virtual void UserSteppingAction(const G4Step* step);
+    
+    void BeginTrack(const G4Track* track);
+    
+    void SetEnabled(G4bool on)           { enabled = on; }
+    void SetSamplingPeriod(G4int period) { sampling_period = period; }
+    
+    // Forwards the tracking hooks; owned by the tracking manager like the
+    // profiler is by the stepping manager.  The tracking action it replaces
+    // is called after the profiler and owned by it.
+    class Tracking : public G4UserTrackingAction
+    {
+    public:
+        Tracking(TS01_Profiler* p, G4UserTrackingAction* n) : profiler(p), next(n) { }
+        virtual ~Tracking() { delete next; }
+        virtual void PreUserTrackingAction(const G4Track* track)
+        {
+            profiler->BeginTrack(track);
+            if (next) next->PreUserTrackingAction(track);
+        }
+        virtual void PostUserTrackingAction(const G4Track* track)
+        {
+            if (next) next->PostUserTrackingAction(track);
+        }
+    private:
+        TS01_Profiler* profiler;
+        G4UserTrackingAction* next;
+    };
+    
+private:
+    G4bool   enabled;
+    G4int    sampling_period;
+    G4int    countdown;
+    G4bool   armed;
+    G4double t0;
+    
+    TS01_Profile* profile;
+};
+
+#endif /* TS01_Profiler_h */
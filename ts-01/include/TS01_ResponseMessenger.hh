@@ -0,0 +1,38 @@
+//
+//  TS01_ResponseMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/response/.  Responses belong to the shared
+//  detector construction and are only changed between runs, so the
+//  commands are not broadcast to workers.
+//
+
+#ifndef TS01_ResponseMessenger_h
+#define TS01_ResponseMessenger_h
+
+#include "G4UImessenger.hh"
+
+class TS01_DetectorConstruction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithoutParameter;
+
+class TS01_ResponseMessenger : public G4UImessenger
+{
+public:
+    TS01_ResponseMessenger(TS01_DetectorConstruction*);
+    virtual ~TS01_ResponseMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+    TS01_DetectorConstruction* detector;
+
+    G4UIdirectory*           response_dir;
+    G4UIcommand*             load_cmd;
+    G4UIcommand*             gains_cmd;
+    G4UIcommand*             assign_cmd;
+    G4UIcmdWithoutParameter* list_cmd;
+};
+
+#endif /* TS01_ResponseMessenger_h */
@@ -0,0 +1,129 @@
+//
+//  TS01_Run.hh
+//  ts_01
+//
+//  Per-thread run record.  Each worker fills its own copy from
+//  TS01_PhotoSD and the master merges them at end of run.  Hit sums are
+//  kept in fixed point (TS01_Fixed), so merged totals do not depend on
+//  the order threads or sharded jobs are added up in.
+//
+
+#ifndef TS01_Run_h
+#define TS01_Run_h
+
+#include <iosfwd>
+#include <vector>
+
+#include "G4Run.hh"
+#include "TS01_Fixed.hh"
+#include "TS01_Histogram.hh"
+#include "TS01_AcceptanceTable.hh"
+#include "TS01_Profile.hh"
+
+class TS01_Run : public G4Run
+{
+public:
+    enum { kHits, kWeightedHits, kTime, kWavelength, kNumHistograms };
+    
+    // TS01_StackingAction counters: photons examined, culled by geometry,
+    // culled by path length, and (validation mode) culled photons detected
+    enum { kCullSeen, kCullGeometry, kCullPath, kCullDetected, kNumCullCounters };
+    
+    // Super-photon mode: Cherenkov photons seen and kept by the stacking action
+    enum { kThinSeen, kThinKept, kNumThinCounters };
+    
+    // Cherenkov photons (weighted) from tracked particles and from
+    // parametrised cascades, counted by the stacking action, and the mean
+    // photons folded with an acceptance table by TS01_Cerenkov
+    enum { kLightTracked, kLightCascade, kLightFolded, kNumLightCounters };
+    
+    // Work done, for --bench-json: optical photons handed to the stacking
+    // action (tracked, sub-event or looked up) and Geant4 steps of all
+    // tracks.  Not written to summaries, like the profile
+    enum { kWorkPhotons, kWorkSteps, kNumWorkCounters };
+    
+    // Written first in every summary; older summaries are not read
+    static const G4int kSummaryVersion = 2;
+    
+    // Histograms are copied (empty) from the kNumHistograms entries of
+    // binning; an acceptance table is only accumulated in build mode
+    TS01_Run(const TS01_Histogram* binning, const TS01_AcceptanceTable* acceptance_binning = NULL);
+    virtual ~TS01_Run();
+
+    virtual void Merge(const G4Run* run);
+
+    void AddEvent(G4int event_id, G4double unweighted, G4double weighted);
+    
+    // Per detected photon: arrival time [ns], wavelength [nm] and the
+    // photon's weight (1 unless thinned)
+    inline void AddHit(G4double time, G4double wl, G4double w = 1.0)
+    {
+        histograms[kTime].Fill(time, w);
+        histograms[kWavelength].Fill(wl, w);
+        sum_hit_weight  += w;
+        sum_hit_weight2 += w*w;
+    }
+
+    inline void CountCull(G4int i) { cull_counts[i]++; }
+    inline void CountThin(G4int i) { thin_counts[i]++; }
+    inline void CountCascade()     { cascades++; }
+    inline void CountLight(G4int i, G4double w) { light[i] += w; }
+    inline void CountWork(G4int i, G4long n)    { work_counts[i] += n; }
+    
+    // Per readout channel: one call per channel with photons in an event
+    void AddChannel(G4int channel, G4double photons, G4double weighted);
+
+    G4int    GetDetectorEvents() const   { return n_events; }
+    G4double GetUnweightedHits() const   { return sum_unweighted.ToDouble(); }
+    G4double GetWeightedHits() const     { return sum_weighted.ToDouble(); }
+    G4double GetUnweightedHits2() const  { return sum2_unweighted.ToDouble(); }
+    G4double GetWeightedHits2() const    { return sum2_weighted.ToDouble(); }
+    
+    const TS01_Histogram& GetHistogram(G4int i) const { return histograms[i]; }
+    G4long   GetCullCount(G4int i) const { return cull_counts[i]; }
+    G4long   GetThinCount(G4int i) const { return thin_counts[i]; }
+    G4long   GetCascades() const         { return cascades; }
+    G4double GetLight(G4int i) const     { return light[i].ToDouble(); }
+    G4long   GetWorkCount(G4int i) const { return work_counts[i]; }
+    
+    // Sum of the weights of detected photons and of their squares
+    G4double GetHitWeight() const        { return sum_hit_weight.ToDouble(); }
+    G4double GetHitWeight2() const       { return sum_hit_weight2.ToDouble(); }
+    const TS01_AcceptanceTable* GetAcceptance() const { return acceptance; }
+    
+    G4int    GetNumberOfChannels() const       { return channel_events.size(); }
+    G4int    GetChannelEvents(G4int c) const   { return channel_events[c]; }
+    G4double GetChannelPhotons(G4int c) const  { return channel_photons[c].ToDouble(); }
+    G4double GetChannelWeighted(G4int c) const { return channel_weighted[c].ToDouble(); }
+    
+    // Filled by TS01_Profiler when profiling is enabled
+    TS01_Profile&       GetProfile()       { return profile; }
+    const TS01_Profile& GetProfile() const { return profile; }
+    
+    // WriteSummary prints sums exactly, so that ReadSummary gives back
+    // the same run (histograms included) for --merge-summaries
+    void   WriteSummary(std::ostream& os) const;
+    G4bool ReadSummary(std::istream& is);
+
+private:
+    G4int    n_events;
+    TS01_Fixed sum_unweighted, sum_weighted;
+    TS01_Fixed sum2_unweighted, sum2_weighted;
+    
+    TS01_Histogram histograms[kNumHistograms];
+    G4long   cull_counts[kNumCullCounters];
+    G4long   thin_counts[kNumThinCounters];
+    G4long   cascades;
+    TS01_Fixed light[kNumLightCounters];
+    G4long   work_counts[kNumWorkCounters];
+    TS01_Fixed sum_hit_weight, sum_hit_weight2;
+    TS01_AcceptanceTable* acceptance;
+    
+    std::vector<G4int>      channel_events;     // events with at least one photon
+    std::vector<TS01_Fixed> channel_photons;
+    std::vector<TS01_Fixed> channel_weighted;
+    
+    TS01_Profile profile;
+};
+
+#endif /* TS01_Run_h */
@@ -0,0 +1,87 @@
+//
+//  TS01_RunAction.hh
+//  ts_01
+//
+
+#ifndef TS01_RunAction_h
+#define TS01_RunAction_h
+
+#include "G4UserRunAction.hh"
+#include "globals.hh"
+#include "TS01_Run.hh"
+
+class TS01_RunMessenger;
+class TS01_Profiler;
+
+class TS01_RunAction : public G4UserRunAction
+{
+public:
+    TS01_RunAction();
+    virtual ~TS01_RunAction();
+
+    virtual G4Run* GenerateRun();
+    virtual void   BeginOfRunAction(const G4Run*);
+    virtual void   EndOfRunAction(const G4Run*);
+    
+    void SetHitFile(const G4String& file) { hit_file = file; }
+    void SetTextHits(G4bool text)         { text_hits = text; }
+    void SetSummaryFile(const G4String& file) { summary_file = file; }
+    void SetBinning(G4int h, G4int nbins, G4double lo, G4double hi)
+    {
+        binning[h].SetBinning(nbins, lo, hi);
+    }
+    
+    // Acceptance table: build mode injects <photons> per event and writes
+    // the merged table to file at end of run, fast mode folds every
+    // optical photon with a table read from file instead of tracking it
+    enum { kAcceptanceOff, kAcceptanceBuild, kAcceptanceFast };
+    void BuildAcceptance(const G4String& file, G4int photons);
+    void LoadAcceptance(const G4String& file);
+    void AcceptanceOff() { acceptance_mode = kAcceptanceOff; }
+    void SetAcceptanceBinning(G4int axis, G4int nbins, G4double lo, G4double hi)
+    {
+        acceptance.SetBinning(axis, nbins, lo, hi);
+    }
+    const TS01_AcceptanceTable* GetAcceptanceBuild() const
+    {
+        return acceptance_mode == kAcceptanceBuild ? &acceptance : NULL;
+    }
+    const TS01_AcceptanceTable* GetAcceptanceFast() const
+    {
+        return acceptance_mode == kAcceptanceFast ? &acceptance : NULL;
+    }
+    
+    // Step profiling: the profiler actions are installed on first use
+    void SetProfiling(G4bool on);
+    void SetProfileSampling(G4int period);
+    void SetProfileTop(G4int top) { profile_top = top; }
+    
+private:
+    void WriteSummary(const TS01_Run* run);
+    
+    TS01_RunMessenger* messenger;
+    
+    G4String hit_file;
+    G4bool   text_hits;
+    
+    G4String summary_file;
+    G4bool   summary_written;
+    TS01_Histogram binning[TS01_Run::kNumHistograms];
+    
+    G4int    acceptance_mode;
+    G4String acceptance_file;
+    TS01_AcceptanceTable acceptance;
+    
+    TS01_Profiler* profiler;        // owned by the stepping manager once installed
+    G4int          profile_sampling;
+    G4int          profile_top;
+    
+    // Last run without parametrised cascades, per event: Cherenkov light,
+    // and QE-weighted hits with their error; the reference runs with
+    // cascades are validated against (cascade-01.mac)
+    G4bool   full_em_valid;
+    G4double full_em_light;
+    G4double full_em_hits, full_em_hits_err;
+};
+
+#endif /* TS01_RunAction_h */
@@ -0,0 +1,60 @@
+//
+//  TS01_RunMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/output/, /ts01/histo/, /ts01/acceptance/,
+//  /ts01/profile/ and /ts01/checkpoint/ controlling per-thread run output,
+//  the in-memory histograms, the acceptance table, step profiling and
+//  checkpoints.
+//
+
+#ifndef TS01_RunMessenger_h
+#define TS01_RunMessenger_h
+
+#include "G4UImessenger.hh"
+#include "TS01_Run.hh"
+
+class TS01_RunAction;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWithAnInteger;
+
+class TS01_RunMessenger : public G4UImessenger
+{
+public:
+    TS01_RunMessenger(TS01_RunAction*);
+    virtual ~TS01_RunMessenger();
+    
+    virtual void SetNewValue(G4UIcommand*, G4String);
+    
+private:
+    TS01_RunAction*     run_action;
+    
+    G4UIdirectory*      ts01_dir;
+    G4UIdirectory*      output_dir;
+    G4UIcmdWithAString* file_cmd;
+    G4UIcmdWithABool*   text_cmd;
+    
+    G4UIdirectory*      histo_dir;
+    G4UIcmdWithAString* summary_cmd;
+    G4UIcommand*        bin_cmd[TS01_Run::kNumHistograms];
+    
+    G4UIdirectory*           acceptance_dir;
+    G4UIcommand*             acc_build_cmd;
+    G4UIcmdWithAString*      acc_load_cmd;
+    G4UIcmdWithoutParameter* acc_off_cmd;
+    G4UIcommand*             acc_bins_cmd;
+    
+    G4UIdirectory*        profile_dir;
+    G4UIcmdWithABool*     prof_enable_cmd;
+    G4UIcmdWithAnInteger* prof_sample_cmd;
+    G4UIcmdWithAnInteger* prof_top_cmd;
+    
+    G4UIdirectory*      checkpoint_dir;
+    G4UIcmdWithAString* ckpt_file_cmd;
+    G4UIcommand*        ckpt_period_cmd;
+};
+
+#endif /* TS01_RunMessenger_h */
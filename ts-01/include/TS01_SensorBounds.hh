@@ -0,0 +1,41 @@
+//
+//  TS01_SensorBounds.hh
+//  ts_01
+//
+//  Bounding volume of the sensors in the ice: the DOM sphere, or the
+//  fiber-ring annulus from the bottom of the fibers to the back of the
+//  PMT bodies, both grown by a safety margin.  Distance() is a pure
+//  function of the bounds and may be called from any thread.
+//
+
+#ifndef TS01_SensorBounds_h
+#define TS01_SensorBounds_h
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class TS01_DetectorConstruction;
+
+class TS01_SensorBounds
+{
+public:
+    TS01_SensorBounds();
+    
+    // Refresh from the current geometry; a sweep can rebuild it between runs
+    void Update(const TS01_DetectorConstruction* det, G4double margin);
+    
+    // Distance along the ray to the bounding volume, 0 inside, < 0 if missed
+    G4double Distance(const G4ThreeVector& x, const G4ThreeVector& u) const;
+    
+    // Same for n rays given as arrays, written without branches so the
+    // loops vectorise
+    void Distance(size_t n, const G4double* x, const G4double* y, const G4double* z,
+                  const G4double* ux, const G4double* uy, const G4double* uz, G4double* d) const;
+    
+private:
+    G4bool   fiber;
+    G4double r_in, r_out, z_lo, z_hi;
+    G4double r_dom;
+};
+
+#endif /* TS01_SensorBounds_h */
@@ -0,0 +1,48 @@
+//
+//  TS01_Shard.hh
+//  ts_01
+//
+//  Event numbering and seeding shared by all threads.  Every event's
+//  random engine is reseeded from (seed, run ID, event ID), so an event
+//  is the same whichever thread or job processes it.  --first-event and
+//  --num-events cut every run down to a range of its events: a job with
+//  /run/beamOn N and --first-event F processes events F, F+1, ... of the
+//  unsharded run, and the summaries of jobs covering 0..N-1 merge
+//  (--merge-summaries) to the summary of the single job.
+//
+
+#ifndef TS01_Shard_h
+#define TS01_Shard_h
+
+#include "globals.hh"
+
+class G4Event;
+
+class TS01_Shard
+{
+public:
+    // Configured from main before any thread starts, read-only after
+    static TS01_Shard* Instance();
+
+    void SetSeed(long s)          { seed = s; }
+    void SetFirstEvent(G4int i)   { first_event = i; }
+    void SetNumberOfEvents(G4int n) { num_events = n; }
+
+    G4bool IsSharded() const      { return first_event > 0 || num_events >= 0; }
+    G4int  GetFirstEvent() const  { return first_event; }
+
+    // Called first in GeneratePrimaries: renumbers the event into the
+    // unsharded run and reseeds for it.  Past the end of the range the
+    // event is marked aborted, the thread's event loop is stopped and
+    // false is returned
+    G4bool BeginEvent(G4Event* evt, G4int run_id) const;
+
+private:
+    TS01_Shard();
+
+    long  seed;
+    G4int first_event;
+    G4int num_events;       // -1 for the rest of the run
+};
+
+#endif /* TS01_Shard_h */
@@ -0,0 +1,66 @@
+//
+//  TS01_SpectralResponse.hh
+//  ts_01
+//
+//  Sensor response applied to detected photons: quantum efficiency times
+//  collection efficiency, interpolated in wavelength, times a per-channel
+//  gain.  Curves are resampled on a uniform 1 nm grid when set so that a
+//  whole event's hits are weighted in one branch-free loop.
+//
+
+#ifndef TS01_SpectralResponse_h
+#define TS01_SpectralResponse_h
+
+#include <iosfwd>
+#include <vector>
+
+#include "globals.hh"
+
+class TS01_SpectralResponse
+{
+public:
+    // Flat unit response from 300 to 700 nm
+    TS01_SpectralResponse(const G4String& name);
+
+    // The bialkali PMT QE that used to be hardcoded in TS01_PhotoSD
+    static TS01_SpectralResponse* Bialkali(const G4String& name);
+
+    const G4String& GetName() const { return name; }
+
+    // Tabulated curve: wavelength [nm], QE and collection efficiency as
+    // fractions; zero outside the tabulated range
+    void SetCurve(const std::vector<G4double>& wl, const std::vector<G4double>& qe,
+                  const std::vector<G4double>& ce);
+
+    // Text file with "<wl [nm]> <qe> [<ce>]" lines, '#' starts a comment
+    G4bool Load(const G4String& file);
+
+    // Text file with "<channel> <gain>" lines; unlisted channels have gain 1
+    G4bool LoadGains(const G4String& file);
+
+    G4double GetGain(G4int channel) const
+    {
+        return (channel >= 0 && channel < (G4int) gains.size()) ? gains[channel] : 1.0;
+    }
+
+    // Largest QE*CE over wavelength (gains not included)
+    G4double GetMaxEfficiency() const;
+
+    // w[i] = QE*CE(wl[i]) * gain(channel[i]) for n hits
+    void Weight(size_t n, const G4double* wl, const G4int* channel, G4double* w) const;
+
+    void Print() const;
+
+    // Everything the weights depend on, exactly, one line
+    void Describe(std::ostream& os) const;
+
+private:
+    G4String name;
+    G4String source;
+
+    G4double wl_lo, wl_hi;       // tabulated range [nm]
+    std::vector<G4double> eff;   // QE*CE on the 1 nm grid from wl_lo
+    std::vector<G4double> gains;
+};
+
+#endif /* TS01_SpectralResponse_h */
@@ -0,0 +1,111 @@
+//
+//  TS01_StackingAction.hh
+//  ts_01
+//
+//  Culls optical photons at birth when a straight line through the ice
+//  cannot reach the bounding volume of any sensor (the DOM sphere or the
+//  fiber-ring cylinder), or when the distance to it exceeds a given number
+//  of ice absorption lengths.  The ice has no scattering tables, so the
+//  straight-line test is exact up to the safety margin; in the layered
+//  ice of --ice-model culling is skipped.  In validation mode
+//  photons are only flagged and TS01_PhotoSD counts flagged hits.
+//
+//  With an acceptance table loaded (/ts01/acceptance/load) every optical
+//  photon is instead folded with the table and killed.
+//
+//  In sub-event mode (/ts01/subevent/enable) optical photons are taken off
+//  the stack into a TS01_PhotonBatch and processed in parallel by the
+//  TS01_PhotonPool when the urgent stack runs dry: photons born in the ice
+//  are moved to the sensor bounding volume (or absorbed) and pushed back
+//  in their original order, with their original track IDs, for detailed
+//  tracking in this event (not with --ice-model); in fast mode the batch
+//  is folded instead.
+//
+//  In super-photon mode (/ts01/thin/) Cherenkov photons, including those
+//  of parametrised cascades (/ts01/cascade/), are kept with a
+//  probability p, the largest QE x CE of the sensor responses in use
+//  times a factor, and carry weight 1/p through tracking and WLS
+//  re-emission; TS01_PhotoSD sums the weights, so SD-W stays unbiased.
+//
+
+#ifndef TS01_StackingAction_h
+#define TS01_StackingAction_h
+
+#include <set>
+
+#include "G4UserStackingAction.hh"
+#include "G4ThreeVector.hh"
+#include "G4MaterialPropertyVector.hh"
+#include "globals.hh"
+#include "TS01_SensorBounds.hh"
+#include "TS01_PhotonBatch.hh"
+
+class TS01_Run;
+class TS01_PhotoSD;
+class TS01_AcceptanceTable;
+class TS01_StackingMessenger;
+class TS01_Telemetry;
+class G4Material;
+class G4VProcess;
+
+class TS01_StackingAction : public G4UserStackingAction
+{
+public:
+    TS01_StackingAction();
+    virtual ~TS01_StackingAction();
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+    virtual void NewStage();
+    virtual void PrepareNewEvent();
+
+    void SetEnabled(G4bool on)           { enabled = on; }
+    void SetValidation(G4bool on)        { validate = on; }
+    void SetMargin(G4double m)           { margin = m; }
+    void SetMaxAbsLengths(G4double n)    { max_abs_lengths = n; }
+    void SetSubEvent(G4bool on)          { subevent = on; }
+    void SetBatchSize(G4int n)           { batch_size = n; }
+    void SetThinning(G4bool on)          { thinning = on; }
+    void SetThinFactor(G4double f)       { thin_factor = f; }
+
+    // True if the track was flagged for culling in validation mode
+    G4bool IsCulled(G4int track_id) const
+    {
+        return validate && culled.count(track_id) > 0;
+    }
+
+private:
+    TS01_StackingMessenger* messenger;
+
+    G4bool   enabled;
+    G4bool   validate;
+    G4double margin;
+    G4double max_abs_lengths;
+
+    // Sensor bounds, refreshed every event since a sweep can rebuild the geometry
+    TS01_SensorBounds bounds;
+    G4MaterialPropertyVector* ice_abs;
+    
+    G4bool   subevent;
+    G4bool   cull_event;        // enabled and subevent as applied to this event
+    G4bool   subevent_event;
+    G4bool   layered_warned;
+    G4int    batch_size;        // photons per pool task
+    G4bool   reinjecting;
+    G4bool   record_only;
+    const G4Material* ice;
+    TS01_PhotonBatch  batch;
+    
+    G4bool   thinning;
+    G4double thin_factor;
+    G4double thin_p;            // survival probability for this event
+    const G4VProcess* cerenkov; // this thread's Cherenkov process, once seen
+    const G4VProcess* cascade;  // and its TS01_CascadeCherenkov
+
+    TS01_Run*     run;
+    const TS01_AcceptanceTable* acceptance;
+    TS01_PhotoSD* photo_sd;
+    TS01_Telemetry* telemetry;
+    std::set<G4int> culled;
+};
+
+#endif /* TS01_StackingAction_h */
@@ -0,0 +1,50 @@
+//
+//  TS01_StackingMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/cull/, /ts01/subevent/ and /ts01/thin/ for
+//  TS01_StackingAction.  The stacking
+//  action only exists on threads that process events, so in MT mode the
+//  commands are broadcast to the workers.
+//
+
+#ifndef TS01_StackingMessenger_h
+#define TS01_StackingMessenger_h
+
+#include "G4UImessenger.hh"
+
+class TS01_StackingAction;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+
+class TS01_StackingMessenger : public G4UImessenger
+{
+public:
+    TS01_StackingMessenger(TS01_StackingAction*);
+    virtual ~TS01_StackingMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+    TS01_StackingAction* stacking;
+
+    G4UIdirectory*             cull_dir;
+    G4UIcmdWithABool*          enable_cmd;
+    G4UIcmdWithABool*          validate_cmd;
+    G4UIcmdWithADoubleAndUnit* margin_cmd;
+    G4UIcmdWithADouble*        abs_cmd;
+    
+    G4UIdirectory*             subevent_dir;
+    G4UIcmdWithABool*          sub_enable_cmd;
+    G4UIcmdWithAnInteger*      sub_threads_cmd;
+    G4UIcmdWithAnInteger*      sub_batch_cmd;
+    
+    G4UIdirectory*             thin_dir;
+    G4UIcmdWithABool*          thin_enable_cmd;
+    G4UIcmdWithADouble*        thin_factor_cmd;
+};
+
+#endif /* TS01_StackingMessenger_h */
@@ -0,0 +1,50 @@
+//
+//  TS01_Sweep.hh
+//  ts_01
+//
+//  In-process geometry parameter sweep.  Each point rebuilds only the
+//  volumes of TS01_DetectorConstruction (materials and physics tables are
+//  kept) and runs the same number of events; one keyed line per point is
+//  appended to the sweep output file.
+//
+
+#ifndef TS01_Sweep_h
+#define TS01_Sweep_h
+
+#include <vector>
+
+#include "globals.hh"
+
+class TS01_DetectorConstruction;
+class TS01_SweepMessenger;
+
+class TS01_Sweep
+{
+public:
+    struct Point
+    {
+        G4bool   fiber;
+        G4double radius;
+        G4double fiber_dia;
+        G4int    num_fiber;
+    };
+    
+    TS01_Sweep(TS01_DetectorConstruction*);
+    ~TS01_Sweep();
+    
+    void AddPoint(const Point& p) { points.push_back(p); }
+    void Clear()                  { points.clear(); }
+    void List() const;
+    void SetOutputFile(const G4String& file) { output_file = file; }
+    
+    void BeamOn(G4int n_events);
+    
+private:
+    TS01_DetectorConstruction* detector;
+    TS01_SweepMessenger*       messenger;
+    
+    std::vector<Point> points;
+    G4String           output_file;
+};
+
+#endif /* TS01_Sweep_h */
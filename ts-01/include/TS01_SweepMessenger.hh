@@ -0,0 +1,40 @@
+//
+//  TS01_SweepMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/sweep/.  These act on the shared detector
+//  construction from the master thread and are not broadcast to workers.
+//
+
+#ifndef TS01_SweepMessenger_h
+#define TS01_SweepMessenger_h
+
+#include "G4UImessenger.hh"
+
+class TS01_Sweep;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+class TS01_SweepMessenger : public G4UImessenger
+{
+public:
+    TS01_SweepMessenger(TS01_Sweep*);
+    virtual ~TS01_SweepMessenger();
+    
+    virtual void SetNewValue(G4UIcommand*, G4String);
+    
+private:
+    TS01_Sweep* sweep;
+    
+    G4UIdirectory*           sweep_dir;
+    G4UIcommand*             add_cmd;
+    G4UIcmdWithoutParameter* clear_cmd;
+    G4UIcmdWithoutParameter* list_cmd;
+    G4UIcmdWithAString*      file_cmd;
+    G4UIcmdWithAnInteger*    beam_cmd;
+};
+
+#endif /* TS01_SweepMessenger_h */
@@ -0,0 +1,103 @@
+//
+//  TS01_Telemetry.hh
+//  ts_01
+//
+//  Live run status on a local Unix socket (--telemetry <path>).  Every
+//  connection gets one JSON object with the run, events done and
+//  requested, event and optical photon rates since the start of the run,
+//  the resident set size, the running SD-W totals and, per thread, the
+//  current event and the events done; e.g.
+//
+//      socat - UNIX-CONNECT:<path>      or      nc -U <path>
+//
+//  Event threads only write counters in their own cache lines with
+//  relaxed loads and stores (one writer each, so no locked instructions);
+//  a server thread reads them when a client connects.  Threads beyond
+//  the slots share one that is updated atomically and not reported.
+//
+
+#ifndef TS01_Telemetry_h
+#define TS01_Telemetry_h
+
+#include <atomic>
+#include <thread>
+
+#include "globals.hh"
+
+class TS01_Telemetry
+{
+public:
+    static TS01_Telemetry* Instance();
+
+    // Master only: start and stop serving on a Unix socket
+    G4bool Start(const G4String& path);
+    void   Stop();
+    G4bool IsEnabled() const { return enabled; }
+
+    // Master at start and end of every run
+    void BeginRun(G4int run_id, G4int n_events);
+    void EndRun();
+
+    // Threads that process events
+    inline void BeginEvent(G4int event_id)
+    {
+        if (enabled) ThreadSlot().event.store(event_id, std::memory_order_relaxed);
+    }
+    inline void CountPhoton()
+    {
+        if (!enabled) return;
+        Slot& slot = ThreadSlot();
+        Bump(slot, slot.photons, 1);
+    }
+    void EndOfEvent(G4double unweighted, G4double weighted);
+
+private:
+    TS01_Telemetry();
+
+    static const G4int kMaxSlots = 256;     // sequential / master, then workers
+
+    struct Counters
+    {
+        std::atomic<G4int>    event;
+        std::atomic<G4long>   events;
+        std::atomic<G4long>   photons;
+        std::atomic<G4double> unweighted;
+        std::atomic<G4double> weighted;
+    };
+    
+    // Padded so that the counters of two threads never share a cache line
+    struct Slot : Counters
+    {
+        char pad[128 - sizeof(Counters)];
+    };
+
+    // A slot of its own has one writer, the shared overflow slot several
+    template <class T, class U>
+    inline void Bump(Slot& slot, std::atomic<T>& counter, U n)
+    {
+        T old = counter.load(std::memory_order_relaxed);
+        if (&slot != &overflow) counter.store(old + n, std::memory_order_relaxed);
+        else while (!counter.compare_exchange_weak(old, old + n, std::memory_order_relaxed)) { }
+    }
+
+    Slot& ThreadSlot();
+    void  Serve();
+    G4String Snapshot() const;
+
+    G4bool      enabled;
+    G4String    socket_path;
+    G4int       listen_fd;
+    std::thread server;
+    std::atomic<G4bool> stop;
+
+    Slot  slots[kMaxSlots];
+    Slot  overflow;                         // threads beyond kMaxSlots, not reported
+
+    std::atomic<G4int>    run_id;
+    std::atomic<G4int>    requested;
+    std::atomic<G4bool>   running;
+    std::atomic<G4double> run_start;
+    std::atomic<G4double> run_end;
+};
+
+#endif /* TS01_Telemetry_h */
@@ -0,0 +1,139 @@
+//
+//  TS01_TrajectoryCapture.hh
+//  ts_01
+//
+//  Bounded-memory trajectories for viewing events with many optical
+//  photons (/ts01/trajectory/).  Optical photon trajectories only record
+//  a decimated set of step points: every step up to <maxPoints>, then
+//  every second, fourth, ... step, so the start and end of the photon
+//  are always kept and a trajectory never holds more than maxPoints + 1
+//  points.  Of the photons without a hit, at most <maxPhotons> per event
+//  are kept, a uniform sample (reservoir sampling) drawn from a generator
+//  seeded by the event number, so the event random numbers do not
+//  change.  Photons that make a hit in TS01_PhotoSD are always kept.  The
+//  kept trajectories are handed to the event at its end; all other
+//  particles are stored by Geant4 as before.
+//
+//  Needs trajectories to be stored (/tracking/storeTrajectory or
+//  /vis/scene/add/trajectories); photons propagated as sub-events are not
+//  tracked and have no trajectory.
+//
+//  As the thread's tracking action it also adds the steps of every track
+//  to the run's work counters, one addition per track.
+//
+
+#ifndef TS01_TrajectoryCapture_h
+#define TS01_TrajectoryCapture_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "G4UserEventAction.hh"
+#include "G4UserTrackingAction.hh"
+#include "G4VTrajectory.hh"
+#include "G4VTrajectoryPoint.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4ParticleDefinition;
+class TS01_Run;
+class TS01_TrajectoryMessenger;
+
+class TS01_Trajectory : public G4VTrajectory
+{
+public:
+    TS01_Trajectory(const G4Track* track, G4int max_points);
+    virtual ~TS01_Trajectory() { }
+
+    virtual G4int    GetTrackID() const  { return track_id; }
+    virtual G4int    GetParentID() const { return parent_id; }
+    virtual G4String GetParticleName() const;
+    virtual G4double GetCharge() const;
+    virtual G4int    GetPDGEncoding() const;
+    virtual G4ThreeVector GetInitialMomentum() const { return momentum; }
+
+    virtual G4int GetPointEntries() const
+    {
+        return points.size() + (steps % stride ? 1 : 0);
+    }
+    virtual G4VTrajectoryPoint* GetPoint(G4int i) const
+    {
+        return i < (G4int) points.size() ? &points[i] : &end;
+    }
+
+    virtual void AppendStep(const G4Step* step);
+    virtual void MergeTrajectory(G4VTrajectory* other);
+
+    // Whether the photon made a hit
+    G4bool IsDetected() const { return detected; }
+
+private:
+    class Point : public G4VTrajectoryPoint
+    {
+    public:
+        Point(const G4ThreeVector& x = G4ThreeVector()) : position(x) { }
+        virtual const G4ThreeVector GetPosition() const { return position; }
+        G4ThreeVector position;
+    };
+
+    G4int track_id;
+    G4int parent_id;
+    const G4ParticleDefinition* particle;
+    G4ThreeVector momentum;
+    G4bool detected;
+
+    G4int  max_points;
+    G4long steps;                           // steps appended
+    G4long stride;                          // points are kept every stride-th step
+    mutable std::vector<Point> points;      // vertex, then steps stride, 2 stride, ...
+    mutable Point end;                      // the last step, unless it is in points
+};
+
+class TS01_TrajectoryCapture : public G4UserTrackingAction
+{
+public:
+    TS01_TrajectoryCapture();
+    virtual ~TS01_TrajectoryCapture();
+
+    virtual void PreUserTrackingAction(const G4Track* track);
+    virtual void PostUserTrackingAction(const G4Track* track);
+
+    void BeginOfEvent(const G4Event* event);
+    void EndOfEvent(const G4Event* event);
+
+    void SetEnabled(G4bool on)       { enabled = on; }
+    void SetMaxPhotons(G4int n)      { max_photons = n; }
+    void SetMaxPoints(G4int n)       { max_points = n; }
+    void SetVerbose(G4int level)     { verbose = level; }
+
+    // Forwards the event hooks; owned by the event manager like the
+    // capture is by the tracking manager
+    class Events : public G4UserEventAction
+    {
+    public:
+        Events(TS01_TrajectoryCapture* c) : capture(c) { }
+        virtual void BeginOfEventAction(const G4Event* event) { capture->BeginOfEvent(event); }
+        virtual void EndOfEventAction(const G4Event* event)   { capture->EndOfEvent(event); }
+    private:
+        TS01_TrajectoryCapture* capture;
+    };
+
+private:
+    void Clear();
+
+    G4bool enabled;
+    G4int  max_photons;
+    G4int  max_points;
+    G4int  verbose;
+
+    TS01_Run* run;                          // of the current event
+    TS01_Trajectory* current;               // of the photon being tracked
+    std::vector<TS01_Trajectory*> detected;
+    std::vector<TS01_Trajectory*> reservoir;
+    G4long   photons;                       // not detected, this event
+    uint64_t state;                         // reservoir generator
+
+    TS01_TrajectoryMessenger* messenger;
+};
+
+#endif /* TS01_TrajectoryCapture_h */
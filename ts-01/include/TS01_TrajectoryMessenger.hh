@@ -0,0 +1,38 @@
+//
+//  TS01_TrajectoryMessenger.hh
+//  ts_01
+//
+//  UI commands under /ts01/trajectory/ for TS01_TrajectoryCapture.  The
+//  capture only exists on threads that process events, so in MT mode the
+//  commands are broadcast to the workers.
+//
+
+#ifndef TS01_TrajectoryMessenger_h
+#define TS01_TrajectoryMessenger_h
+
+#include "G4UImessenger.hh"
+
+class TS01_TrajectoryCapture;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
+
+class TS01_TrajectoryMessenger : public G4UImessenger
+{
+public:
+    TS01_TrajectoryMessenger(TS01_TrajectoryCapture*);
+    virtual ~TS01_TrajectoryMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+    TS01_TrajectoryCapture* capture;
+
+    G4UIdirectory*        trajectory_dir;
+    G4UIcmdWithABool*     enable_cmd;
+    G4UIcmdWithAnInteger* photons_cmd;
+    G4UIcmdWithAnInteger* points_cmd;
+    G4UIcmdWithAnInteger* verbose_cmd;
+};
+
+#endif /* TS01_TrajectoryMessenger_h */
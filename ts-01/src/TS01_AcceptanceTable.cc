@@ -0,0 +1,320 @@
+//
+//  TS01_AcceptanceTable.cc
+//  ts_01
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_IceModel.hh"
+#include "TS01_AcceptanceTable.hh"
+
+namespace
+{
+    void PrintGeometry(std::ostream& os, const TS01_AcceptanceGeometry& g)
+    {
+        if (g.fiber_mode)
+            os << g.num_fiber << " fibers of " << g.fiber_dia << " x " << g.fiber_len
+               << " mm at radius " << g.det_radius << " mm, PMTs " << g.pmt_radius << " x "
+               << g.pmt_face_z << " + " << g.pmt_body_z << " mm";
+        else
+            os << "DOM of radius " << g.dom_radius << " mm, glass " << g.dom_glass
+               << " mm, PMT shell " << g.dom_pmt_radius << " + " << g.dom_pmt_glass
+               << " mm from " << g.dom_pmt_theta << " deg";
+        os << ", world half length " << g.world_half << " mm";
+    }
+
+    // FNV-1a, as for the physics cache keys
+    uint64_t Hash(const std::string& desc)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i=0; i<desc.size(); i++)
+        {
+            h ^= (unsigned char) desc[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+}
+
+TS01_AcceptanceTable::TS01_AcceptanceTable() :
+    photons(1000)
+{
+    SetBinning(kRho,        20, 0.0, 125.0*cm);
+    SetBinning(kZ,          20, -125.0*cm, 125.0*cm);
+    SetBinning(kCosTheta,   10, -1.0, 1.0);
+    SetBinning(kDPhi,        6, 0.0, pi);
+    SetBinning(kWavelength,  8, 250.0, 650.0);
+}
+
+void TS01_AcceptanceTable::SetBinning(G4int axis, G4int n, G4double l, G4double h)
+{
+    if (n <= 0 || !(h > l))
+    {
+        G4ExceptionDescription msg;
+        msg << "Bad binning " << n << " " << l << " " << h << " for acceptance axis " << axis;
+        G4Exception("TS01_AcceptanceTable::SetBinning", "TS01_Acceptance001", JustWarning, msg);
+        return;
+    }
+    nbins[axis]     = n;
+    lo[axis]        = l;
+    hi[axis]        = h;
+    inv_width[axis] = n / (h - l);
+}
+
+G4int TS01_AcceptanceTable::GetNumberOfBins() const
+{
+    G4int n = 1;
+    for (G4int a=0; a<kNumAxes; a++) n *= nbins[a];
+    return n;
+}
+
+void TS01_AcceptanceTable::Reset()
+{
+    const size_t n = GetNumberOfBins();
+    injected.assign(n, 0.0);
+    detected_u.assign(n, 0.0);
+    detected_w.assign(n, 0.0);
+    prob_u.clear();
+    prob_w.clear();
+}
+
+void TS01_AcceptanceTable::Merge(const TS01_AcceptanceTable& other)
+{
+    if (other.injected.size() != injected.size())
+    {
+        G4Exception("TS01_AcceptanceTable::Merge", "TS01_Acceptance002", JustWarning,
+                    "Acceptance tables with different binning not merged");
+        return;
+    }
+    for (size_t i=0; i<injected.size(); i++)
+    {
+        injected[i]   += other.injected[i];
+        detected_u[i] += other.detected_u[i];
+        detected_w[i] += other.detected_w[i];
+    }
+}
+
+void TS01_AcceptanceTable::SamplePhoton(G4int bin, G4ThreeVector& x, G4ThreeVector& u,
+                                        G4double& wl) const
+{
+    // Unpack the bin, last axis fastest as in FindBin
+    G4int i[kNumAxes];
+    for (G4int a=kNumAxes-1; a>=0; a--)
+    {
+        i[a] = bin % nbins[a];
+        bin /= nbins[a];
+    }
+    G4double v[kNumAxes];
+    for (G4int a=0; a<kNumAxes; a++)
+        v[a] = lo[a] + (i[a] + G4UniformRand()) / inv_width[a];
+
+    // Uniform in area for rho, random position azimuth, direction azimuth
+    // at +-dphi from the radial direction
+    const G4double r0  = lo[kRho] + i[kRho] / inv_width[kRho];
+    const G4double r1  = r0 + 1.0 / inv_width[kRho];
+    const G4double rho = sqrt(r0*r0 + G4UniformRand()*(r1*r1 - r0*r0));
+    const G4double phi = twopi*G4UniformRand();
+    x.set(rho*cos(phi), rho*sin(phi), v[kZ]);
+
+    const G4double cost = v[kCosTheta];
+    const G4double sint = sqrt(fmax(0.0, 1.0 - cost*cost));
+    const G4double az   = phi + (G4UniformRand() < 0.5 ? v[kDPhi] : -v[kDPhi]);
+    u.set(sint*cos(az), sint*sin(az), cost);
+
+    wl = v[kWavelength];
+}
+
+void TS01_AcceptanceTable::UpdateProbabilities()
+{
+    const size_t n = injected.size();
+    prob_u.assign(n, 0.0);
+    prob_w.assign(n, 0.0);
+    for (size_t i=0; i<n; i++)
+    {
+        if (injected[i] <= 0.0) continue;
+        prob_u[i] = detected_u[i] / injected[i];
+        prob_w[i] = detected_w[i] / injected[i];
+    }
+}
+
+G4bool TS01_AcceptanceTable::Write(const G4String& file, const TS01_DetectorConstruction* det) const
+{
+    FILE* fp = fopen(file.c_str(), "wb");
+    if (fp == NULL)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot write acceptance table " << file;
+        G4Exception("TS01_AcceptanceTable::Write", "TS01_Acceptance003", JustWarning, msg);
+        return false;
+    }
+
+    TS01_AcceptanceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TS01ACC", 8);
+    header.version = version;
+    DescribeGeometry(det, header.geometry);
+    header.ice      = IceHash();
+    header.response = ResponseHash(det);
+    header.photons  = photons;
+    for (G4int a=0; a<kNumAxes; a++)
+    {
+        header.nbins[a] = nbins[a];
+        header.lo[a]    = lo[a];
+        header.hi[a]    = hi[a];
+    }
+
+    const size_t n = injected.size();
+    G4bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                fwrite(&injected[0],   sizeof(G4double), n, fp) == n &&
+                fwrite(&detected_u[0], sizeof(G4double), n, fp) == n &&
+                fwrite(&detected_w[0], sizeof(G4double), n, fp) == n;
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok)
+    {
+        G4ExceptionDescription msg;
+        msg << "Error writing acceptance table " << file;
+        G4Exception("TS01_AcceptanceTable::Write", "TS01_Acceptance003", JustWarning, msg);
+    }
+    return ok;
+}
+
+G4bool TS01_AcceptanceTable::Read(const G4String& file, const TS01_DetectorConstruction* det)
+{
+    FILE* fp = fopen(file.c_str(), "rb");
+    TS01_AcceptanceHeader header;
+    if (fp == NULL || fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, "TS01ACC", 8) != 0 || header.version != version)
+    {
+        if (fp) fclose(fp);
+        G4ExceptionDescription msg;
+        msg << "Cannot read acceptance table " << file;
+        G4Exception("TS01_AcceptanceTable::Read", "TS01_Acceptance004", JustWarning, msg);
+        return false;
+    }
+
+    // A table only describes the geometry it was built for
+    TS01_AcceptanceGeometry geometry;
+    DescribeGeometry(det, geometry);
+    if (memcmp(&geometry, &header.geometry, sizeof(geometry)) != 0)
+    {
+        fclose(fp);
+        G4ExceptionDescription msg;
+        msg << "Acceptance table " << file << " was built for another geometry, not loaded\n"
+            << "  table:   ";
+        PrintGeometry(msg, header.geometry);
+        msg << "\n  current: ";
+        PrintGeometry(msg, geometry);
+        G4Exception("TS01_AcceptanceTable::Read", "TS01_Acceptance005", JustWarning, msg);
+        return false;
+    }
+    if (header.ice != IceHash() || header.response != ResponseHash(det))
+    {
+        fclose(fp);
+        G4ExceptionDescription msg;
+        msg << "Acceptance table " << file << " was built with other "
+            << (header.ice != IceHash() ? "ice optics or ice model (--ice-model)" : "spectral responses")
+            << ", not loaded";
+        G4Exception("TS01_AcceptanceTable::Read", "TS01_Acceptance006", JustWarning, msg);
+        return false;
+    }
+
+    photons = header.photons;
+    for (G4int a=0; a<kNumAxes; a++)
+        SetBinning(a, header.nbins[a], header.lo[a], header.hi[a]);
+    if (!CheckSymmetry(det))
+    {
+        fclose(fp);
+        return false;
+    }
+    Reset();
+
+    const size_t n = injected.size();
+    const G4bool ok = fread(&injected[0],   sizeof(G4double), n, fp) == n &&
+                      fread(&detected_u[0], sizeof(G4double), n, fp) == n &&
+                      fread(&detected_w[0], sizeof(G4double), n, fp) == n;
+    fclose(fp);
+    if (!ok)
+    {
+        G4ExceptionDescription msg;
+        msg << "Truncated acceptance table " << file;
+        G4Exception("TS01_AcceptanceTable::Read", "TS01_Acceptance004", JustWarning, msg);
+        Reset();
+        return false;
+    }
+    UpdateProbabilities();
+    return true;
+}
+
+void TS01_AcceptanceTable::DescribeGeometry(const TS01_DetectorConstruction* det,
+                                            TS01_AcceptanceGeometry& g)
+{
+    // Zeroed padding included, so geometries compare with memcmp
+    memset(&g, 0, sizeof(g));
+    g.fiber_mode = det->IsFiber() ? 1 : 0;
+    g.world_half = det->GetWorldHalfLength() / mm;
+    if (g.fiber_mode)
+    {
+        g.num_fiber  = det->GetNumFiber();
+        g.fiber_dia  = det->GetFiberDiameter() / mm;
+        g.fiber_len  = det->GetFiberLength() / mm;
+        g.det_radius = det->GetDetectorRadius() / mm;
+        g.pmt_radius = det->GetPMTRadius() / mm;
+        g.pmt_face_z = det->GetPMTFaceLength() / mm;
+        g.pmt_body_z = det->GetPMTBodyLength() / mm;
+    }
+    else
+    {
+        g.dom_radius     = det->GetDOMRadius() / mm;
+        g.dom_glass      = det->GetDOMGlass() / mm;
+        g.dom_pmt_radius = det->GetDOMPMTRadius() / mm;
+        g.dom_pmt_glass  = det->GetDOMPMTGlass() / mm;
+        g.dom_pmt_theta  = det->GetDOMPMTTheta() / deg;
+    }
+}
+
+uint64_t TS01_AcceptanceTable::IceHash()
+{
+    std::ostringstream os;
+    os.precision(17);
+    const G4Material* ice = G4Material::GetMaterial("Ice", false);
+    const G4MaterialPropertiesTable* mpt = ice ? ice->GetMaterialPropertiesTable() : NULL;
+    const char* properties[] = { "RINDEX", "ABSLENGTH" };
+    for (G4int i=0; i<2; i++)
+    {
+        const G4MaterialPropertyVector* v = mpt ? mpt->GetProperty(properties[i]) : NULL;
+        os << properties[i];
+        for (size_t j=0; v && j<v->GetVectorLength(); j++) os << " " << v->Energy(j) << " " << (*v)[j];
+        os << "\n";
+    }
+    TS01_IceModel::Instance()->Describe(os);
+    return Hash(os.str());
+}
+
+uint64_t TS01_AcceptanceTable::ResponseHash(const TS01_DetectorConstruction* det)
+{
+    std::ostringstream os;
+    det->DescribeResponses(os);
+    return Hash(os.str());
+}
+
+G4bool TS01_AcceptanceTable::CheckSymmetry(const TS01_DetectorConstruction* det) const
+{
+    if (!det->IsFiber()) return true;
+    const G4double spacing = twopi * det->GetDetectorRadius() / det->GetNumFiber();
+    if (spacing <= 1.0 / inv_width[kRho]) return true;
+
+    G4ExceptionDescription msg;
+    msg << det->GetNumFiber() << " fibers are " << spacing / mm << " mm apart, more than the "
+        << 1.0 / inv_width[kRho] / mm << " mm rho bins; the ring is not symmetric enough for "
+        << "an acceptance table";
+    G4Exception("TS01_AcceptanceTable::CheckSymmetry", "TS01_Acceptance007", JustWarning, msg);
+    return false;
+}
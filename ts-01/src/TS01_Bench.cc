@@ -0,0 +1,127 @@
+//
+//  TS01_Bench.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <sys/resource.h>
+
+#include "G4AutoLock.hh"
+#include "G4RunManager.hh"
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_Run.hh"
+#include "TS01_OpticalCache.hh"
+#include "TS01_Bench.hh"
+
+namespace
+{
+    G4Mutex bench_mutex = G4MUTEX_INITIALIZER;
+    
+    G4double Now()
+    {
+        return std::chrono::duration<G4double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    G4double PeakRSS()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0*1024.0);   // bytes
+#else
+        return usage.ru_maxrss / 1024.0;            // kB
+#endif
+    }
+}
+
+TS01_Bench* TS01_Bench::Instance()
+{
+    static TS01_Bench* instance = NULL;
+    if (instance == NULL) instance = new TS01_Bench;
+    return instance;
+}
+
+TS01_Bench::TS01_Bench() :
+    t_start(Now()),
+    t_run(0.0),
+    t_events(-1.0),
+    init_time(-1.0)
+{
+    
+}
+
+void TS01_Bench::BeginRun()
+{
+    if (!IsEnabled()) return;
+    
+    G4AutoLock lock(&bench_mutex);
+    t_run    = Now();
+    t_events = -1.0;
+}
+
+void TS01_Bench::BeginThreadRun()
+{
+    if (!IsEnabled()) return;
+    
+    // Workers build their geometry and physics before they begin the run
+    G4AutoLock lock(&bench_mutex);
+    if (t_events >= 0.0) return;
+    t_events = Now();
+    if (init_time < 0.0) init_time = t_events - t_start;
+}
+
+void TS01_Bench::EndRun(const TS01_Run* run)
+{
+    if (!IsEnabled()) return;
+    
+    G4AutoLock lock(&bench_mutex);
+    const G4double run_time = Now() - (t_events >= 0.0 ? t_events : t_run);
+    lock.unlock();
+    const G4double rate     = run_time > 0.0 ? 1.0 / run_time : 0.0;
+    
+    G4RunManager* rm = G4RunManager::GetRunManager();
+    const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+        rm->GetUserDetectorConstruction());
+    G4int threads = 0;
+#ifdef G4MULTITHREADED
+    if (rm->GetRunManagerType() == G4RunManager::masterRM)
+        threads = static_cast<G4MTRunManager*>(rm)->GetNumberOfThreads();
+#endif
+    
+    const G4long events  = run->GetNumberOfEvent();
+    const G4long photons = run->GetWorkCount(TS01_Run::kWorkPhotons) +
+                           llround(run->GetLight(TS01_Run::kLightFolded));
+    const G4long steps   = run->GetWorkCount(TS01_Run::kWorkSteps);
+    
+    FILE* fp = fopen(file_name.c_str(), "a");
+    if (fp == NULL)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot append to benchmark file " << file_name;
+        G4Exception("TS01_Bench::EndRun", "TS01_Bench001", JustWarning, msg);
+        return;
+    }
+    fprintf(fp, "{\"label\": \"%s\", \"run\": %d, \"mode\": \"%s\", \"num_fiber\": %d, "
+                "\"param_ring\": %s, \"fiber_dia_mm\": %g, \"radius_cm\": %g, \"threads\": %d, "
+                "\"optics_cache\": %s, "
+                "\"events\": %ld, \"optical_photons\": %ld, \"steps\": %ld, "
+                "\"init_s\": %.3f, \"run_s\": %.3f, \"events_per_s\": %.3f, "
+                "\"optical_photons_per_s\": %.1f, \"steps_per_s\": %.1f, \"peak_rss_mb\": %.1f}\n",
+            bench_label.c_str(), run->GetRunID(), det->IsFiber() ? "fiber" : "dom",
+            det->GetNumFiber(), det->IsParameterisedRing() ? "true" : "false",
+            det->GetFiberDiameter() / CLHEP::mm,
+            det->GetDetectorRadius() / CLHEP::cm, threads,
+            TS01_OpticalCache::Instance()->IsEnabled() ? "true" : "false",
+            (long) events, (long) photons, (long) steps,
+            init_time, run_time, events * rate, photons * rate, steps * rate, PeakRSS());
+    fclose(fp);
+    
+    G4cout << "Benchmark: " << events * rate << " events/s, " << photons * rate
+           << " optical photons/s, " << steps * rate << " steps/s -> " << file_name << G4endl;
+}
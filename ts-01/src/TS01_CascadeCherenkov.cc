@@ -0,0 +1,228 @@
+//
+//  TS01_CascadeCherenkov.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4Gamma.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4RunManager.hh"
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4Poisson.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include "TS01_Run.hh"
+#include "TS01_CascadeMessenger.hh"
+#include "TS01_CascadeCherenkov.hh"
+
+namespace
+{
+    const G4int kTableBins = 4096;
+
+    // Inverse CDF of a density sampled at kTableBins+1 uniform points in
+    // [x0, x1], on kTableBins+1 uniform points in [0, 1] and a copy so
+    // Lookup() can always read [j+1]; integral gets the integral
+    std::vector<G4double> InverseCDF(const std::vector<G4double>& pdf, G4double x0, G4double x1,
+                                     G4double& integral)
+    {
+        const G4double dx = (x1 - x0) / kTableBins;
+        std::vector<G4double> cdf(kTableBins + 1, 0.0);
+        for (G4int i=1; i<=kTableBins; i++) cdf[i] = cdf[i-1] + 0.5 * (pdf[i-1] + pdf[i]) * dx;
+        integral = cdf[kTableBins];
+
+        std::vector<G4double> inverse(kTableBins + 2, x1);
+        G4int i = 0;
+        for (G4int j=0; j<=kTableBins; j++)
+        {
+            const G4double c = integral * j / kTableBins;
+            while (i < kTableBins - 1 && cdf[i+1] < c) i++;
+            const G4double dc = cdf[i+1] - cdf[i];
+            const G4double w  = dc > 0.0 ? std::min(std::max((c - cdf[i]) / dc, 0.0), 1.0) : 0.0;
+            inverse[j] = x0 + (i + w) * dx;
+        }
+        inverse[kTableBins + 1] = inverse[kTableBins];
+        return inverse;
+    }
+
+    // Raedel and Wiebusch (2012): track length and longitudinal profile
+    // per particle type, and the angular profile of electrons (those of
+    // positrons and photons differ by less than the fit errors)
+    const G4double kElectron[] = { 532.07078881, 1.00000211, 2.01849, 0.63176, 0.63207 };
+    const G4double kPositron[] = { 532.11320598, 0.99999254, 2.00035, 0.63190, 0.63008 };
+    const G4double kGamma[]    = { 532.08540905, 0.99999877, 2.83923, 0.58209, 0.64526 };
+    const G4double kAngle[]    = { 4.27033, -6.02527, 0.29887, -0.00103 };
+}
+
+TS01_CascadeCherenkov::TS01_CascadeCherenkov(const G4String& name) :
+    G4VDiscreteProcess(name, fParameterisation),
+    enabled(false),
+    threshold(1.0*GeV),
+    max_photons(200000),
+    ice(NULL),
+    tables_built(false),
+    photons_per_length(0.0)
+{
+    messenger = new TS01_CascadeMessenger(this);
+}
+
+TS01_CascadeCherenkov::~TS01_CascadeCherenkov()
+{
+    delete messenger;
+}
+
+G4bool TS01_CascadeCherenkov::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return &particle == G4Electron::Definition() || &particle == G4Positron::Definition() ||
+           &particle == G4Gamma::Definition();
+}
+
+G4double TS01_CascadeCherenkov::GetMeanFreePath(const G4Track&, G4double, G4ForceCondition*)
+{
+    return DBL_MAX;
+}
+
+G4double TS01_CascadeCherenkov::PostStepGetPhysicalInteractionLength(const G4Track& track, G4double,
+                                                                     G4ForceCondition* condition)
+{
+    *condition = NotForced;
+    if (!enabled || track.GetKineticEnergy() < threshold) return DBL_MAX;
+
+    if (ice == NULL) ice = G4Material::GetMaterial("Ice", false);
+    if (track.GetMaterial() != ice) return DBL_MAX;
+    if (!tables_built) BuildTables();
+
+    // Takes over at once
+    return photons_per_length > 0.0 ? 0.0 : DBL_MAX;
+}
+
+G4bool TS01_CascadeCherenkov::BuildTables()
+{
+    tables_built = true;
+    G4MaterialPropertiesTable* mpt = ice ? ice->GetMaterialPropertiesTable() : NULL;
+    const G4MaterialPropertyVector* rindex = mpt ? mpt->GetProperty("RINDEX") : NULL;
+    if (rindex == NULL || rindex->GetVectorLength() < 2)
+    {
+        G4ExceptionDescription msg;
+        msg << "No RINDEX for the ice, cascades are left to full tracking";
+        G4Exception("TS01_CascadeCherenkov::BuildTables", "TS01_Cascade001", JustWarning, msg);
+        return false;
+    }
+
+    // Frank-Tamm for beta = 1: dN/dx dE = 369.81 / (eV cm) (1 - 1/n(E)^2)
+    const G4double e_low  = rindex->Energy(0);
+    const G4double e_high = rindex->Energy(rindex->GetVectorLength() - 1);
+    std::vector<G4double> pdf(kTableBins + 1);
+    G4double sum = 0.0, sum_e = 0.0;
+    for (G4int i=0; i<=kTableBins; i++)
+    {
+        const G4double e = e_low + (e_high - e_low) * i / kTableBins;
+        const G4double n = rindex->Value(e);
+        pdf[i] = std::max(0.0, 1.0 - 1.0 / (n*n));
+        sum   += pdf[i];
+        sum_e += pdf[i] * e;
+    }
+    G4double integral;
+    energy = InverseCDF(pdf, e_low, e_high, integral);
+    photons_per_length = 369.81 / (eV*cm) * integral;
+    if (photons_per_length <= 0.0) return false;
+
+    // One Cherenkov angle for all photons, that of the spectrum-weighted
+    // mean photon energy (see the header)
+    const G4double n = rindex->Value(sum_e / sum);
+    for (G4int i=0; i<=kTableBins; i++)
+    {
+        const G4double x = -1.0 + 2.0 * i / kTableBins;
+        pdf[i] = std::max(0.0, kAngle[0] * exp(kAngle[1] * pow(fabs(x - 1.0/n), kAngle[2])) + kAngle[3]);
+    }
+    cos_theta = InverseCDF(pdf, -1.0, 1.0, integral);
+
+    G4cout << "TS01_CascadeCherenkov: " << photons_per_length * cm << " photons/cm between "
+           << e_low / eV << " and " << e_high / eV << " eV, n " << n << G4endl;
+    return true;
+}
+
+G4double TS01_CascadeCherenkov::Lookup(const std::vector<G4double>& table, G4double u)
+{
+    const G4double f = u * kTableBins;
+    const G4int    j = (G4int) f;
+    const G4double w = f - j;
+    return table[j] + w*(table[j+1] - table[j]);
+}
+
+G4VParticleChange* TS01_CascadeCherenkov::PostStepDoIt(const G4Track& track, const G4Step&)
+{
+    aParticleChange.Initialize(track);
+
+    const G4ParticleDefinition* particle = track.GetDefinition();
+    const G4double* fit = particle == G4Gamma::Definition() ? kGamma :
+                          (particle == G4Positron::Definition() ? kPositron : kElectron);
+    const G4double e_gev = track.GetKineticEnergy() / GeV;
+
+    // Beyond max_photons the photons share the light equally
+    const G4double mean = fit[0] * pow(e_gev, fit[1]) * cm * photons_per_length;
+    G4long   n = max_photons;
+    G4double w = track.GetWeight();
+    if (mean > max_photons)
+        w *= mean / max_photons;
+    else
+        n = G4Poisson(mean);
+
+    // Depth in radiation lengths ~ Gamma(a, b); a only stays positive
+    // somewhat below the fitted range
+    const G4double a  = std::max(fit[2] + fit[3] * log(e_gev), 0.5);
+    const G4double x0 = ice->GetRadlen();
+
+    const G4ThreeVector& start = track.GetPosition();
+    const G4ThreeVector& axis  = track.GetMomentumDirection();
+    const G4VPhysicalVolume* world =
+        G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+    const G4double exit = world->GetLogicalVolume()->GetSolid()->DistanceToOut(start, axis);
+
+    aParticleChange.SetSecondaryWeightByProcess(true);
+    aParticleChange.SetNumberOfSecondaries(n);
+    for (G4long i=0; i<n; i++)
+    {
+        const G4double depth = CLHEP::RandGamma::shoot(a, fit[4]) * x0;
+        if (depth > exit) continue;
+
+        const G4double e     = Lookup(energy, G4UniformRand());
+        const G4double cos_t = Lookup(cos_theta, G4UniformRand());
+        const G4double sin_t = sqrt(std::max(0.0, 1.0 - cos_t*cos_t));
+        const G4double phi   = twopi * G4UniformRand();
+        G4ThreeVector dir(sin_t*cos(phi), sin_t*sin(phi), cos_t);
+        dir.rotateUz(axis);
+
+        // Polarised in the plane of the photon and the axis, as Cherenkov light
+        G4ThreeVector pol = axis - dir * dir.dot(axis);
+        pol = pol.mag2() > 1e-12 ? pol.unit() : dir.orthogonal().unit();
+
+        G4DynamicParticle* photon = new G4DynamicParticle(G4OpticalPhoton::OpticalPhotonDefinition(),
+                                                          dir, e);
+        photon->SetPolarization(pol.x(), pol.y(), pol.z());
+        G4Track* secondary = new G4Track(photon, track.GetGlobalTime() + depth / c_light,
+                                         start + depth * axis);
+        secondary->SetWeight(w);
+        aParticleChange.AddSecondary(secondary);
+    }
+
+    static_cast<TS01_Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun())->CountCascade();
+
+    aParticleChange.ProposeLocalEnergyDeposit(track.GetKineticEnergy());
+    aParticleChange.ProposeTrackStatus(fStopAndKill);
+    return &aParticleChange;
+}
@@ -0,0 +1,55 @@
+//
+//  TS01_CascadeMessenger.cc
+//  ts_01
+//
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "TS01_CascadeCherenkov.hh"
+#include "TS01_CascadeMessenger.hh"
+
+TS01_CascadeMessenger::TS01_CascadeMessenger(TS01_CascadeCherenkov* c) :
+    cascade(c)
+{
+    cascade_dir = new G4UIdirectory("/ts01/cascade/");
+    cascade_dir->SetGuidance("Parametrised Cherenkov light of electromagnetic cascades in the ice.");
+
+    enable_cmd = new G4UIcmdWithABool("/ts01/cascade/enable", this);
+    enable_cmd->SetGuidance("Replace e-, e+ and gamma above the threshold in the ice by the");
+    enable_cmd->SetGuidance("Cherenkov photons of their cascade, without tracking it.");
+    enable_cmd->SetParameterName("enable", true);
+    enable_cmd->SetDefaultValue(true);
+
+    threshold_cmd = new G4UIcmdWithADoubleAndUnit("/ts01/cascade/threshold", this);
+    threshold_cmd->SetGuidance("Kinetic energy from which a particle is parametrised (the fits");
+    threshold_cmd->SetGuidance("hold above about 1 GeV).");
+    threshold_cmd->SetParameterName("energy", false);
+    threshold_cmd->SetDefaultUnit("GeV");
+    threshold_cmd->SetRange("energy > 0");
+
+    photons_cmd = new G4UIcmdWithAnInteger("/ts01/cascade/maxPhotons", this);
+    photons_cmd->SetGuidance("Photons emitted per cascade at most; brighter cascades emit");
+    photons_cmd->SetGuidance("super-photons of equal weight.");
+    photons_cmd->SetParameterName("photons", false);
+    photons_cmd->SetRange("photons > 0");
+}
+
+TS01_CascadeMessenger::~TS01_CascadeMessenger()
+{
+    delete photons_cmd;
+    delete threshold_cmd;
+    delete enable_cmd;
+    delete cascade_dir;
+}
+
+void TS01_CascadeMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    if (cmd == enable_cmd)
+        cascade->SetEnabled(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == threshold_cmd)
+        cascade->SetThreshold(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(value));
+    else if (cmd == photons_cmd)
+        cascade->SetMaxPhotons(G4UIcmdWithAnInteger::GetNewIntValue(value));
+}
@@ -0,0 +1,141 @@
+//
+//  TS01_Cerenkov.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <algorithm>
+
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4Material.hh"
+#include "G4ProcessManager.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4RunManager.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include "TS01_AcceptanceTable.hh"
+#include "TS01_PhotoSD.hh"
+#include "TS01_Run.hh"
+#include "TS01_Cerenkov.hh"
+
+namespace
+{
+    // Photons sampled per step to average the acceptance over the cone
+    const G4int kMaxSamples = 8;
+}
+
+TS01_Cerenkov::TS01_Cerenkov(G4Cerenkov* cerenkov) :
+    G4Cerenkov("TS01Cerenkov", cerenkov->GetProcessType()),
+    original(cerenkov),
+    table(NULL),
+    photo_sd(NULL)
+{
+    SetMaxNumPhotonsPerStep(original->GetMaxNumPhotonsPerStep());
+    SetMaxBetaChange(original->GetMaxBetaChange());
+    SetTrackSecondariesFirst(original->GetTrackSecondariesFirst());
+    SetVerboseLevel(original->GetVerboseLevel());
+}
+
+void TS01_Cerenkov::AddTo(G4ProcessManager* pm)
+{
+    pm->AddProcess(this);
+    pm->SetProcessOrdering(this, idxPostStep);
+    managers.push_back(pm);
+}
+
+void TS01_Cerenkov::SetAcceptance(const TS01_AcceptanceTable* t, TS01_PhotoSD* sd)
+{
+    // Only one of the two makes light; activation only changes with the table
+    if ((t != NULL) != (table != NULL))
+        for (size_t i=0; i<managers.size(); i++) managers[i]->SetProcessActivation(original, t == NULL);
+    table    = t;
+    photo_sd = sd;
+}
+
+G4double TS01_Cerenkov::PostStepGetPhysicalInteractionLength(const G4Track& track, G4double previous,
+                                                             G4ForceCondition* condition)
+{
+    // Idle without a table, with G4Cerenkov's step limits with one
+    if (table == NULL)
+    {
+        *condition = NotForced;
+        return DBL_MAX;
+    }
+    return G4Cerenkov::PostStepGetPhysicalInteractionLength(track, previous, condition);
+}
+
+G4double TS01_Cerenkov::PhotonsPerLength(const G4MaterialPropertyVector* rindex, G4double z, G4double beta)
+{
+    // Frank-Tamm: dN/dx dE = 369.81 z^2 / (eV cm) (1 - 1/(beta n(E))^2),
+    // trapezoids between the RINDEX points
+    G4double sum = 0.0, f0 = 0.0;
+    for (size_t i=0; i<rindex->GetVectorLength(); i++)
+    {
+        const G4double bn = beta * (*rindex)[i];
+        const G4double f  = std::max(0.0, 1.0 - 1.0 / (bn*bn));
+        if (i > 0) sum += 0.5 * (f0 + f) * (rindex->Energy(i) - rindex->Energy(i-1));
+        f0 = f;
+    }
+    return 369.81 / (eV*cm) * z*z * sum;
+}
+
+G4VParticleChange* TS01_Cerenkov::PostStepDoIt(const G4Track& track, const G4Step& step)
+{
+    aParticleChange.Initialize(track);
+    if (table == NULL) return &aParticleChange;
+
+    const G4MaterialPropertiesTable* mpt = track.GetMaterial()->GetMaterialPropertiesTable();
+    const G4MaterialPropertyVector* rindex = mpt ? mpt->GetProperty("RINDEX") : NULL;
+    if (rindex == NULL || rindex->GetVectorLength() < 2) return &aParticleChange;
+
+    // Mean count as G4Cerenkov: the average of the two ends of the step
+    const G4StepPoint* pre  = step.GetPreStepPoint();
+    const G4StepPoint* post = step.GetPostStepPoint();
+    const G4double z    = track.GetDefinition()->GetPDGCharge() / eplus;
+    const G4double mean = step.GetStepLength() * 0.5 *
+        (PhotonsPerLength(rindex, z, pre->GetBeta()) + PhotonsPerLength(rindex, z, post->GetBeta()));
+
+    const G4double beta     = 0.5 * (pre->GetBeta() + post->GetBeta());
+    const G4double cos_min  = 1.0 / (beta * rindex->GetMaxValue());
+    const G4double sin2_max = (1.0 - cos_min) * (1.0 + cos_min);
+    if (mean <= 0.0 || sin2_max <= 0.0) return &aParticleChange;
+
+    const G4double e_min = rindex->Energy(0);
+    const G4double e_max = rindex->Energy(rindex->GetVectorLength() - 1);
+    const G4ThreeVector  start = pre->GetPosition();
+    const G4ThreeVector  delta = post->GetPosition() - start;
+    const G4ThreeVector& axis  = pre->GetMomentumDirection();
+
+    const G4int n = std::min(kMaxSamples, (G4int) ceil(mean));
+    G4double sum_u = 0.0, sum_w = 0.0;
+    for (G4int i=0; i<n; i++)
+    {
+        // Photon energy as G4Cerenkov: flat, kept with sin^2 theta over its maximum
+        G4double e, cos_t, sin2;
+        do
+        {
+            e     = e_min + G4UniformRand() * (e_max - e_min);
+            cos_t = 1.0 / (beta * rindex->Value(e));
+            sin2  = (1.0 - cos_t) * (1.0 + cos_t);
+        } while (G4UniformRand() * sin2_max > sin2);
+
+        // Azimuths stratified around the cone, positions along the step
+        const G4double phi   = twopi * (i + G4UniformRand()) / n;
+        const G4double sin_t = sqrt(sin2);
+        G4ThreeVector dir(sin_t*cos(phi), sin_t*sin(phi), cos_t);
+        dir.rotateUz(axis);
+
+        G4double p_u, p_w;
+        table->Lookup(start + G4UniformRand() * delta, dir, 1240.0*eV / e, p_u, p_w);
+        sum_u += p_u;
+        sum_w += p_w;
+    }
+
+    const G4double photons = track.GetWeight() * mean;
+    if (photo_sd) photo_sd->AddExpected(photons / n * sum_u, photons / n * sum_w);
+    static_cast<TS01_Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun())->CountLight(
+        TS01_Run::kLightFolded, photons);
+    return &aParticleChange;
+}
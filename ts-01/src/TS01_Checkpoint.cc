@@ -0,0 +1,292 @@
+//
+//  TS01_Checkpoint.cc
+//  ts_01
+//
+
+#include <stdio.h>
+#include <limits.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "G4Threading.hh"
+#include "G4AutoLock.hh"
+#include "TS01_Run.hh"
+#include "TS01_Checkpoint.hh"
+
+namespace
+{
+    G4Mutex checkpoint_mutex = G4MUTEX_INITIALIZER;
+
+    G4double Now()
+    {
+        return std::chrono::duration<G4double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+G4ThreadLocal TS01_Checkpoint::ThreadState* TS01_Checkpoint::thread_state = NULL;
+
+TS01_Checkpoint* TS01_Checkpoint::Instance()
+{
+    static TS01_Checkpoint* instance = NULL;
+    if (instance == NULL) instance = new TS01_Checkpoint;
+    return instance;
+}
+
+TS01_Checkpoint::TS01_Checkpoint() :
+    period_events(1000),
+    period_seconds(0.0),
+    active(false),
+    run_id(-1),
+    events_since(0),
+    last_time(0.0),
+    generation(0),
+    running(0),
+    waiting(0)
+{
+
+}
+
+void TS01_Checkpoint::SetPeriod(G4int events, G4double seconds)
+{
+    period_events  = events;
+    period_seconds = seconds;
+}
+
+G4bool TS01_Checkpoint::Resume(const G4String& file)
+{
+    std::ifstream is(file.c_str());
+    G4String tag;
+    G4int version;
+    // Version 3: summaries versioned, with the light counters
+    if (!(is >> tag >> version) || tag != "checkpoint" || version != 3)
+    {
+        G4ExceptionDescription msg;
+        msg << file << " is not a ts_01 checkpoint";
+        G4Exception("TS01_Checkpoint::Resume", "TS01_Checkpoint001", JustWarning, msg);
+        return false;
+    }
+
+    G4int id = -1, n_parts = 0;
+    while (is >> tag)
+    {
+        if (tag == "run")
+        {
+            is >> id;
+            continue;
+        }
+        G4int n;
+        if (tag != "part" || id < 0 || !(is >> n)) break;
+
+        Part part;
+        part.done.resize(n);
+        for (G4int i=0; i<n; i++) is >> part.done[i].first >> part.done[i].second;
+
+        // The summary block runs up to its "end" line
+        G4String line;
+        std::getline(is, line);
+        while (std::getline(is, line) && line != "end") part.summary += line + "\n";
+        if (!is) break;
+        resumed[id].push_back(part);
+        n_parts++;
+    }
+    if (!is.eof())
+    {
+        G4ExceptionDescription msg;
+        msg << "Checkpoint " << file << " is damaged after " << n_parts << " parts";
+        G4Exception("TS01_Checkpoint::Resume", "TS01_Checkpoint002", JustWarning, msg);
+        resumed.clear();
+        return false;
+    }
+
+    // Later checkpoints go to the same file unless told otherwise
+    file_name = file;
+    G4cout << "TS01_Checkpoint: resuming " << resumed.size() << " runs from " << file << G4endl;
+    return true;
+}
+
+void TS01_Checkpoint::BeginRun(G4int id, G4bool enable)
+{
+    run_id = id;
+    active = enable && file_name != "";
+    slots.clear();
+    carried.clear();
+    done.clear();
+    events_since = 0;
+    last_time = Now();
+    generation = 0;
+    running = 0;
+    waiting = 0;
+
+    std::map<G4int, std::vector<Part> >::iterator i = resumed.find(id);
+    if (i == resumed.end()) return;
+    carried.swap(i->second);
+    resumed.erase(i);
+
+    for (size_t p=0; p<carried.size(); p++)
+        done.insert(done.end(), carried[p].done.begin(), carried[p].done.end());
+    std::sort(done.begin(), done.end());
+
+    G4int n = 0;
+    for (size_t r=0; r<done.size(); r++) n += done[r].second - done[r].first + 1;
+    G4cout << "TS01_Checkpoint: run " << id << " resumes with " << n << " events done" << G4endl;
+}
+
+G4bool TS01_Checkpoint::IsDone(G4int event_id) const
+{
+    if (done.empty()) return false;
+
+    // Last range starting at or before event_id
+    Ranges::const_iterator r = std::upper_bound(done.begin(), done.end(),
+                                                std::make_pair(event_id, INT_MAX));
+    return r != done.begin() && (--r)->second >= event_id;
+}
+
+void TS01_Checkpoint::BeginThreadRun()
+{
+    if (thread_state == NULL) thread_state = new ThreadState;
+    thread_state->done.clear();
+    
+    // Not behind a generation started before this thread joined
+    G4AutoLock lock(&checkpoint_mutex);
+    thread_state->generation = generation;
+    running++;
+}
+
+void TS01_Checkpoint::EndOfEvent(G4int event_id, const TS01_Run* run)
+{
+    if (!active) return;
+    thread_state->done.push_back(event_id);
+
+    if (++events_since >= period_events ||
+        (period_seconds > 0.0 && Now() - last_time >= period_seconds))
+    {
+        // Checked again, as another thread may just have started it
+        G4AutoLock lock(&checkpoint_mutex);
+        if (events_since >= period_events ||
+            (period_seconds > 0.0 && Now() - last_time >= period_seconds))
+        {
+            events_since = 0;
+            last_time = Now();
+            generation++;
+            waiting = running;
+        }
+    }
+
+    // Every thread brings its slot up to date at its next event
+    if (thread_state->generation < generation)
+    {
+        G4AutoLock lock(&checkpoint_mutex);
+        UpdateSlot(*thread_state, run);
+    }
+}
+
+void TS01_Checkpoint::EndThreadRun(const TS01_Run* run)
+{
+    if (!active) return;
+    G4AutoLock lock(&checkpoint_mutex);
+    UpdateSlot(*thread_state, run);
+    running--;
+}
+
+void TS01_Checkpoint::EndRun(TS01_Run* run)
+{
+    if (!carried.empty())
+    {
+        TS01_Histogram binning[TS01_Run::kNumHistograms];
+        for (G4int h=0; h<TS01_Run::kNumHistograms; h++) binning[h] = run->GetHistogram(h);
+        for (size_t p=0; p<carried.size(); p++)
+        {
+            TS01_Run part(binning);
+            std::istringstream is(carried[p].summary);
+            if (part.ReadSummary(is))
+                run->Merge(&part);
+            else
+            {
+                G4ExceptionDescription msg;
+                msg << "Unreadable results in checkpoint part " << p << " of run " << run_id;
+                G4Exception("TS01_Checkpoint::EndRun", "TS01_Checkpoint003", JustWarning, msg);
+            }
+        }
+    }
+    if (!active) return;
+
+    // The run is complete: keep it for the files of later runs
+    std::ostringstream os;
+    os << "run " << run_id << "\n";
+    for (size_t p=0; p<carried.size(); p++) os << Serialize(carried[p]);
+    for (std::map<G4int, Part>::const_iterator s=slots.begin(); s!=slots.end(); s++)
+        os << Serialize(s->second);
+    finished += os.str();
+    carried.clear();
+    slots.clear();
+    Write();
+}
+
+TS01_Checkpoint::Part TS01_Checkpoint::MakePart(const ThreadState& state, const TS01_Run* run) const
+{
+    std::vector<G4int> ids(state.done);
+    std::sort(ids.begin(), ids.end());
+
+    Part part;
+    for (size_t i=0; i<ids.size(); i++)
+    {
+        if (part.done.empty() || ids[i] != part.done.back().second + 1)
+            part.done.push_back(std::make_pair(ids[i], ids[i]));
+        else
+            part.done.back().second = ids[i];
+    }
+    std::ostringstream os;
+    run->WriteSummary(os);
+    part.summary = os.str();
+    return part;
+}
+
+void TS01_Checkpoint::UpdateSlot(ThreadState& state, const TS01_Run* run)
+{
+    slots[G4Threading::G4GetThreadId()] = MakePart(state, run);
+    
+    // The last slot of a generation writes the file
+    if (state.generation < generation)
+    {
+        state.generation = generation;
+        if (--waiting == 0) Write();
+    }
+}
+
+G4String TS01_Checkpoint::Serialize(const Part& part)
+{
+    std::ostringstream os;
+    os << "part " << part.done.size() << "\n";
+    for (size_t r=0; r<part.done.size(); r++)
+        os << part.done[r].first << " " << part.done[r].second << "\n";
+    os << part.summary << "end\n";
+    return os.str();
+}
+
+void TS01_Checkpoint::Write() const
+{
+    // Replaced in one rename, so a kill never leaves half a checkpoint
+    const G4String tmp_name = file_name + ".tmp";
+    {
+        std::ofstream os(tmp_name.c_str());
+        os << "checkpoint 3\n" << finished;
+        if (!carried.empty() || !slots.empty())
+        {
+            os << "run " << run_id << "\n";
+            for (size_t p=0; p<carried.size(); p++) os << Serialize(carried[p]);
+            for (std::map<G4int, Part>::const_iterator s=slots.begin(); s!=slots.end(); s++)
+                os << Serialize(s->second);
+        }
+        if (!os.flush())
+        {
+            G4ExceptionDescription msg;
+            msg << "Cannot write checkpoint " << tmp_name;
+            G4Exception("TS01_Checkpoint::Write", "TS01_Checkpoint004", JustWarning, msg);
+            return;
+        }
+    }
+    rename(tmp_name.c_str(), file_name.c_str());
+}
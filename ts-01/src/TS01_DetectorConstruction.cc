@@ -1,31 +1,122 @@
 #include <math.h>
+#include <algorithm>
 #include "G4Box.hh"
 #include "G4Tubs.hh"
 #include "G4Sphere.hh"
 #include "G4Orb.hh"
 #include "G4LogicalVolume.hh"
+#include "G4PVParameterised.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Timer.hh"
 #include "G4SystemOfUnits.hh"
 #include "TS01_DetectorConstruction.hh"
 #include "G4LogicalSkinSurface.hh"
 #include "G4LogicalBorderSurface.hh"
 #include "G4VisAttributes.hh"
+#include "G4SDManager.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "TS01_FiberLightGuide.hh"
+#include "TS01_SpectralResponse.hh"
+#include "TS01_ResponseMessenger.hh"
 #include "TS01_PhotoSD.hh"
+#include "TS01_OpticalCache.hh"
+#include "TS01_IceModel.hh"
+#include "TS01_FiberRingParameterisation.hh"
 
 TS01_DetectorConstruction::TS01_DetectorConstruction(bool fiber, int n, G4double dia, G4double r) :
+    paramRing(false),
+    fiberFastSim(false),
     num_fiber(n),
     fiber_dia(dia),
     fiber_len(2.0*CLHEP::m),
     det_radius(r),
     pmt_face_z(1.0*CLHEP::mm),
     pmt_body_z(5.0*CLHEP::mm),
-    fibers(n)
+    dom_radius(16.51*CLHEP::cm),
+    dom_glass(1.27*CLHEP::cm),
+    dom_pmt_radius(134.0*CLHEP::mm),
+    dom_pmt_glass(2.7*CLHEP::mm),
+    dom_pmt_theta(127.0*CLHEP::deg),
+    world_half(1.25*CLHEP::m),
+    polystyrene(NULL), pmma(NULL), fp(NULL),
+    vacuum(NULL), air(NULL), ice(NULL), glass(NULL), al(NULL),
+    gel(NULL),
+    fibers(n),
+    ring_param(NULL)
 {
     doFiber = fiber;
+    responses.push_back(TS01_SpectralResponse::Bialkali("bialkali"));
+    response_messenger = new TS01_ResponseMessenger(this);
+}
+
+void TS01_DetectorConstruction::SetGeometry(bool fiber, int n, G4double dia, G4double r)
+{
+    doFiber    = fiber;
+    num_fiber  = n;
+    fiber_dia  = dia;
+    det_radius = r;
 }
 
 TS01_DetectorConstruction::~TS01_DetectorConstruction()
 {
     for (auto fiber : fibers) delete fiber;
+    delete ring_param;
+    delete response_messenger;
+    for (auto response : responses) delete response;
+}
+
+TS01_SpectralResponse* TS01_DetectorConstruction::GetResponse(const G4String& name, G4bool create)
+{
+    for (auto response : responses)
+        if (response->GetName() == name) return response;
+    if (!create) return NULL;
+    responses.push_back(new TS01_SpectralResponse(name));
+    return responses.back();
+}
+
+void TS01_DetectorConstruction::AssignResponse(const G4String& volume, const G4String& response)
+{
+    TS01_SpectralResponse* r = GetResponse(response);
+    if (r == NULL)
+    {
+        G4ExceptionDescription msg;
+        msg << "No response named " << response;
+        G4Exception("TS01_DetectorConstruction::AssignResponse", "TS01_Response003", JustWarning, msg);
+        return;
+    }
+    volume_response[volume] = r;
+}
+
+const TS01_SpectralResponse* TS01_DetectorConstruction::GetVolumeResponse(const G4String& volume) const
+{
+    std::map<G4String, TS01_SpectralResponse*>::const_iterator i = volume_response.find(volume);
+    return i != volume_response.end() ? i->second : responses[0];
+}
+
+G4double TS01_DetectorConstruction::GetMaxEfficiency() const
+{
+    G4double e = responses[0]->GetMaxEfficiency();
+    for (auto& v : volume_response) e = std::max(e, v.second->GetMaxEfficiency());
+    return e;
+}
+
+void TS01_DetectorConstruction::ListResponses() const
+{
+    for (auto response : responses) response->Print();
+    for (auto& v : volume_response)
+        G4cout << "volume " << v.first << " -> " << v.second->GetName() << G4endl;
+}
+
+void TS01_DetectorConstruction::DescribeResponses(std::ostream& os) const
+{
+    os << "default ";
+    responses[0]->Describe(os);
+    for (auto& v : volume_response)
+    {
+        os << "volume " << v.first << " ";
+        v.second->Describe(os);
+    }
 }
 
 void TS01_DetectorConstruction::ConstructMaterials()
@@ -100,22 +191,27 @@ void TS01_DetectorConstruction::ConstructFibers(G4LogicalVolume *w)
                                         polystyrene, "PlasticFiberLV");
     
     pmt_face = new G4LogicalVolume(new G4Tubs("PMT",
-                                              0.0, 0.6*fiber_dia, 0.5*pmt_face_z,
+                                              0.0, GetPMTRadius(), 0.5*pmt_face_z,
                                               0.0, 360.0*deg),
                                    ice, "PhotoCathode_LV");
     
     pmt_body = new G4LogicalVolume(new G4Tubs("PMT",
-                                              0.0, 0.6*fiber_dia, 0.5*pmt_body_z,
+                                              0.0, GetPMTRadius(), 0.5*pmt_body_z,
                                               0.0, 360.0*deg),
                                    al, "PMT_LV");
     
-    TS01_PhotoSD *photo_sd = new TS01_PhotoSD("TS01/Photomultiplier", "PMTHitsCollection");
-    SetSensitiveDetector(pmt_face, photo_sd);
-    
     fiber_core_lv->SetVisAttributes(G4VisAttributes(G4Colour(0.1, 0.75, 0.1, 0.5)));
     fiber_outer_clad_lv->SetVisAttributes(G4VisAttributes(false));
     fiber_inner_clad_lv->SetVisAttributes(G4VisAttributes(false));
     
+    // The region outlives a geometry rebuild, only the new root is added
+    if (fiberFastSim)
+    {
+        G4Region* region = G4RegionStore::GetInstance()->GetRegion("FiberRegion", false);
+        if (region == NULL) region = new G4Region("FiberRegion");
+        region->AddRootLogicalVolume(fiber_outer_clad_lv);
+    }
+    
     inner = new G4PVPlacement(NULL, G4ThreeVector(0.0, 0.0, 0.0),
                               fiber_inner_clad_lv, "Cladding",
                               fiber_outer_clad_lv, false, 0);
@@ -123,6 +219,12 @@ void TS01_DetectorConstruction::ConstructFibers(G4LogicalVolume *w)
                               fiber_core_lv, "Core",
                               fiber_inner_clad_lv, false, 0);
     
+    if (paramRing)
+    {
+        ConstructFiberRing(w);
+        return;
+    }
+    
     const double PI = 2.0 * std::acos(0.0);
     
     for (int i=0; i<num_fiber; i++)
@@ -151,6 +253,63 @@ void TS01_DetectorConstruction::ConstructFibers(G4LogicalVolume *w)
     }
 }
 
+void TS01_DetectorConstruction::ConstructFiberRing(G4LogicalVolume *w)
+{
+    // One channel = fiber + photocathode + PMT body in an ice tube; the
+    // channels are parameterised around a ring so the geometry holds one
+    // physical volume and one border surface regardless of num_fiber.
+    const G4double chan_r  = GetPMTRadius();
+    const G4double chan_hz = 0.5*(fiber_len + pmt_face_z + pmt_body_z);
+    const G4double z0      = 0.5*(pmt_face_z + pmt_body_z);
+
+    // The channel tubes (and the PMTs they hold) must not overlap their
+    // neighbours, or navigation in the ring is undefined
+    const G4double pitch = 2.0*M_PI*det_radius / num_fiber;
+    if (pitch < 2.0*chan_r)
+    {
+        G4ExceptionDescription msg;
+        msg << num_fiber << " channels of " << 2.0*chan_r / mm << " mm do not fit on a ring of radius "
+            << det_radius / cm << " cm (pitch " << pitch / mm << " mm); use fewer or thinner fibers";
+        G4Exception("TS01_DetectorConstruction::ConstructFiberRing", "TS01_Geometry001",
+                    FatalException, msg);
+        return;
+    }
+
+    G4LogicalVolume* channel_lv = new G4LogicalVolume(new G4Tubs("FiberChannel",
+                                                                 0.0, chan_r, chan_hz,
+                                                                 0.0, 360.0*deg),
+                                                      ice, "FiberChannelLV");
+    G4LogicalVolume* ring_lv = new G4LogicalVolume(new G4Tubs("FiberRing",
+                                                              det_radius - chan_r,
+                                                              det_radius + chan_r, chan_hz,
+                                                              0.0, 360.0*deg),
+                                                   ice, "FiberRingLV");
+    channel_lv->SetVisAttributes(G4VisAttributes(false));
+    ring_lv->SetVisAttributes(G4VisAttributes(false));
+    
+    new G4PVPlacement(NULL, G4ThreeVector(0.0, 0.0, -z0),
+                      fiber_outer_clad_lv, "DetectorFiber",
+                      channel_lv, false, 0);
+    G4VPhysicalVolume* pv_det =
+        new G4PVPlacement(NULL, G4ThreeVector(0.0, 0.0, 0.5*(fiber_len+pmt_face_z) - z0),
+                          pmt_face, "PhotoCathode",
+                          channel_lv, false, 0);
+    G4VPhysicalVolume* pv_pmt =
+        new G4PVPlacement(NULL, G4ThreeVector(0.0, 0.0, 0.5*(fiber_len+pmt_body_z)+pmt_face_z - z0),
+                          pmt_body, "PMTBody",
+                          channel_lv, false, 0);
+    
+    new G4LogicalBorderSurface("PMTin", pv_det, pv_pmt, photocathode);
+    
+    new G4PVPlacement(NULL, G4ThreeVector(0.0, 0.0, z0), ring_lv, "FiberRing",
+                      w, false, 0);
+    
+    delete ring_param;
+    ring_param = new TS01_FiberRingParameterisation(det_radius, num_fiber);
+    new G4PVParameterised("FiberChannel", channel_lv, ring_lv, kUndefined,
+                          num_fiber, ring_param);
+}
+
 void TS01_DetectorConstruction::ConstructDOM(G4LogicalVolume *w)
 {
     G4double p_k[] = {2.00*eV, 3.47*eV};
@@ -161,34 +320,31 @@ void TS01_DetectorConstruction::ConstructDOM(G4LogicalVolume *w)
     pcSurfProp->AddProperty("REFLECTIVITY", p_k, refl_k, 2);
     pcSurfProp->AddProperty("EFFICIENCY",   p_k, effi_k, 2);
     
-    dom_sphere = new G4LogicalVolume(new G4Orb("DOMSphere", 16.51*CLHEP::cm),
+    dom_sphere = new G4LogicalVolume(new G4Orb("DOMSphere", dom_radius),
                                      glass, "DOMPressureVessel");
     
     dom_sphere->SetVisAttributes(G4VisAttributes(G4Colour(0.4, 0.4, 0.8, 0.4)));
                                  
-    dom_interior = new G4LogicalVolume(new G4Orb("DOMInnerVoid", (16.51-1.27)*CLHEP::cm),
+    dom_interior = new G4LogicalVolume(new G4Orb("DOMInnerVoid", dom_radius - dom_glass),
                                        gel, "DOMInstrumentVolume");
     
     dom_interior->SetVisAttributes(G4VisAttributes(G4Colour(0.9, 0.9, 0.9, 0.05)));
     
     dom_pmt_pc = new G4LogicalVolume(new G4Sphere("R7081Sphere",
-                                                  134.0*CLHEP::mm,
-                                                  136.7* CLHEP::mm,
+                                                  dom_pmt_radius,
+                                                  dom_pmt_radius + dom_pmt_glass,
                                                   0.0,
                                                   360.0*CLHEP::deg,
-                                                  127.0*CLHEP::deg,
+                                                  dom_pmt_theta,
                                                   180.0*CLHEP::deg),
                                      glass, "PMTEnvelope");
     dom_pmt_vac = new G4LogicalVolume(new G4Sphere("R7081VAC",
-                                                   0.0, 134.0*CLHEP::mm,
+                                                   0.0, dom_pmt_radius,
                                                    0.0, 360.0*CLHEP::deg,
-                                                   127.0*CLHEP::deg,
+                                                   dom_pmt_theta,
                                                    180.0*CLHEP::deg),
                                       vacuum, "PMTVacuum");
     
-    TS01_PhotoSD *photo_sd = new TS01_PhotoSD("TS01/Photomultiplier", "PMTHitsCollection");
-    SetSensitiveDetector(dom_pmt_pc, photo_sd);
-    
     dom_pmt_pc->SetVisAttributes(G4VisAttributes(G4Colour(0.75, 0.65, 0.1, 0.2)));
     
     G4VPhysicalVolume *pv_dom = new G4PVPlacement(NULL, G4ThreeVector(), dom_sphere,
@@ -205,19 +361,25 @@ void TS01_DetectorConstruction::ConstructDOM(G4LogicalVolume *w)
 
 G4VPhysicalVolume* TS01_DetectorConstruction::Construct()
 {
-    ConstructMaterials();
+    // Materials and their optical tables survive ReinitializeGeometry, only
+    // the volumes and surfaces below are rebuilt
+    if (ice == NULL)
+    {
+        ConstructMaterials();
+        add_ice_optics();
+        add_air_optics();
+        add_glass_optics();
+        add_wls_optics();
+        TS01_OpticalCache::Instance()->Build();
+        TS01_IceModel::Instance()->SetMaterial(ice);
+    }
 
 	G4LogicalVolume* world_lv = new G4LogicalVolume(
-		new G4Box("WorldBox", 1.25*m, 1.25*m, 1.25*m),
+		new G4Box("WorldBox", world_half, world_half, world_half),
 		ice, "IceBox");
     G4VPhysicalVolume* world = new G4PVPlacement(NULL, G4ThreeVector(), world_lv,
                                                  "World", NULL, false, 0, true);
     
-    add_ice_optics();
-    add_air_optics();
-    add_glass_optics();
-    add_wls_optics();
-    
     // PMT optical surface to interface with the fiber (absorbing metallic plaque)
     photocathode = new G4OpticalSurface("cathode",
                                         glisur,
@@ -239,13 +401,51 @@ G4VPhysicalVolume* TS01_DetectorConstruction::Construct()
     world_lv->SetVisAttributes(G4VisAttributes(G4Colour(0.25, 0.75, 0.625, 0.33)));
     
     if (doFiber)
+    {
+        G4Timer timer;
+        timer.Start();
         ConstructFibers(world_lv);
+        timer.Stop();
+        G4cout << "TS01_DetectorConstruction: " << num_fiber << " fibers as "
+               << (paramRing ? "parameterised ring" : "placements") << ", "
+               << G4PhysicalVolumeStore::GetInstance()->size() << " physical volumes, "
+               << G4LogicalBorderSurface::GetNumberOfBorderSurfaces() << " border surfaces, "
+               << timer.GetRealElapsed() << " s" << G4endl;
+    }
     else
         ConstructDOM(world_lv);
 
 	return world;
 }
 
+void TS01_DetectorConstruction::ConstructSDandField()
+{
+    // Called once per worker thread (and by the sequential run manager) so
+    // each thread gets its own photomultiplier SD.  After a geometry
+    // reinitialisation the thread's existing SD is attached to the new volumes.
+    G4SDManager* sdm = G4SDManager::GetSDMpointer();
+    G4VSensitiveDetector *photo_sd = sdm->FindSensitiveDetector("/TS01/Photomultiplier", false);
+    if (photo_sd == NULL)
+    {
+        photo_sd = new TS01_PhotoSD("TS01/Photomultiplier", "PMTHitsCollection");
+        sdm->AddNewDetector(photo_sd);
+    }
+    
+    // A parameterised ring numbers channels on the FiberChannel level
+    static_cast<TS01_PhotoSD*>(photo_sd)->SetChannelDepth(doFiber && paramRing ? 1 : 0);
+    
+    if (doFiber)
+        SetSensitiveDetector(pmt_face, photo_sd);
+    else
+        SetSensitiveDetector(dom_pmt_pc, photo_sd);
+    
+    // Fast simulation models are thread-local like the SD; the region's
+    // manager keeps the model across geometry rebuilds
+    G4Region* region = G4RegionStore::GetInstance()->GetRegion("FiberRegion", false);
+    if (region && region->GetFastSimulationManager() == NULL)
+        new TS01_FiberLightGuide("TS01_FiberLightGuide", region);
+}
+
 void TS01_DetectorConstruction::add_air_optics(void)
 {
     G4double pp[] = { 1.0*CLHEP::eV, 6.0*CLHEP::eV };
@@ -0,0 +1,239 @@
+//
+//  TS01_FiberLightGuide.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <algorithm>
+
+#include "G4Tubs.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4DynamicParticle.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Poisson.hh"
+#include "Randomize.hh"
+#include "TS01_FiberLightGuide.hh"
+
+// Guided photons are handed back this far inside the fiber end so the
+// following full-tracking step crosses the end face
+static const G4double kEndGap = 1.0*nm;
+
+static G4double Property(const G4Material* m, const char* name, G4double e)
+{
+    G4MaterialPropertiesTable* mpt = m->GetMaterialPropertiesTable();
+    if (mpt == NULL) return 0.0;
+    G4MaterialPropertyVector* v = mpt->GetProperty(name);
+    return v ? v->Value(e) : 0.0;
+}
+
+TS01_FiberLightGuide::TS01_FiberLightGuide(const G4String& name, G4Region* region) :
+    G4VFastSimulationModel(name, region),
+    emission(NULL)
+{
+
+}
+
+TS01_FiberLightGuide::~TS01_FiberLightGuide() { }
+
+G4bool TS01_FiberLightGuide::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+G4bool TS01_FiberLightGuide::ModelTrigger(const G4FastTrack& fastTrack)
+{
+    Path path;
+    return Trace(fastTrack, path);
+}
+
+G4bool TS01_FiberLightGuide::Trace(const G4FastTrack& fastTrack, Path& path) const
+{
+    // The envelope is the outer cladding; the inner cladding and the core
+    // are its only descendants, centred on the fiber axis
+    G4LogicalVolume* outer_lv = fastTrack.GetEnvelopeLogicalVolume();
+    if (outer_lv->GetNoDaughters() != 1) return false;
+    G4LogicalVolume* inner_lv = outer_lv->GetDaughter(0)->GetLogicalVolume();
+    if (inner_lv->GetNoDaughters() != 1) return false;
+    G4LogicalVolume* core_lv = inner_lv->GetDaughter(0)->GetLogicalVolume();
+
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    if (track->GetVolume()->GetLogicalVolume() != core_lv) return false;
+
+    const G4double e  = track->GetKineticEnergy();
+    const G4double n0 = Property(core_lv->GetMaterial(), "RINDEX", e);
+    const G4double n1 = Property(inner_lv->GetMaterial(), "RINDEX", e);
+    if (n0 <= 0.0 || n1 <= 0.0) return false;
+
+    const G4Tubs* core = static_cast<const G4Tubs*>(core_lv->GetSolid());
+    const G4double r   = core->GetOuterRadius();
+    const G4ThreeVector x = fastTrack.GetPrimaryTrackLocalPosition();
+    const G4ThreeVector u = fastTrack.GetPrimaryTrackLocalDirection();
+
+    // n u_z and n (x × u)_z are conserved in a cylindrical fiber.  The ray
+    // cannot propagate in the inner cladding, i.e. is totally reflected at
+    // every bounce off the core wall, if n1^2 < beta^2 + (L/r)^2
+    const G4double beta = n0*u.z();
+    const G4double L    = n0*(x.x()*u.y() - x.y()*u.x());
+    if (n1*n1 >= beta*beta + L*L/(r*r)) return false;
+
+    if (fabs(u.z()) < 1.0e-6) return false;
+    const G4double hz = core->GetZHalfLength();
+    const G4double dz = (u.z() > 0.0 ? hz - kEndGap : -hz + kEndGap) - x.z();
+
+    // Nothing to gain near the end, and a photon just placed there must
+    // not be picked up again
+    if (fabs(dz) < r) return false;
+
+    path.core   = core_lv->GetMaterial();
+    path.core_r = r;
+    path.length = dz / u.z();
+    return true;
+}
+
+void TS01_FiberLightGuide::Propagate(G4double r, G4double s, G4ThreeVector& x, G4ThreeVector& u)
+{
+    x.setZ(x.z() + s*u.z());
+
+    const G4double ut = u.perp();
+    if (ut < 1.0e-12) return;
+
+    // Projected on the transverse plane the ray runs along chords of the
+    // core circle.  A chord has impact parameter b and half-length h, and
+    // each bounce rotates it by 2 acos(b/r) about the axis.
+    const G4double dx  = u.x()/ut, dy = u.y()/ut;
+    const G4double l   = x.x()*dy - x.y()*dx;
+    const G4double sgn = l >= 0.0 ? 1.0 : -1.0;
+    const G4double b   = std::min(fabs(l), r);
+    const G4double h   = sqrt(r*r - b*b);
+    if (h <= 0.0) return;
+
+    const G4double psi0 = atan2(dy, dx) - sgn*halfpi;
+    const G4double d    = (x.x()*dx + x.y()*dy) + h + s*ut;   // from the chord start
+    const G4double k    = floor(d / (2.0*h));
+    const G4double se   = d - 2.0*h*k - h;
+    const G4double psi  = psi0 + sgn*fmod(2.0*k*acos(b/r), twopi);
+
+    const G4double c = cos(psi), sn = sin(psi);
+    x.setX(b*c - sgn*se*sn);
+    x.setY(b*sn + sgn*se*c);
+    u.setX(-sgn*ut*sn);
+    u.setY( sgn*ut*c);
+}
+
+G4double TS01_FiberLightGuide::SampleEmission(const G4MaterialPropertyVector* spectrum, G4double e_max)
+{
+    const size_t n = spectrum->GetVectorLength();
+    if (spectrum != emission)
+    {
+        emission = spectrum;
+        emission_cdf.assign(n, 0.0);
+        for (size_t i=1; i<n; i++)
+            emission_cdf[i] = emission_cdf[i-1] +
+                0.5*((*spectrum)[i-1] + (*spectrum)[i])*(spectrum->Energy(i) - spectrum->Energy(i-1));
+    }
+    if (n < 2 || emission_cdf[n-1] <= 0.0) return 0.0;
+
+    // As G4OpWLS: resample energies above the absorbed photon's, give up after 100
+    for (G4int j=0; j<100; j++)
+    {
+        const G4double y = G4UniformRand()*emission_cdf[n-1];
+        size_t i = std::upper_bound(emission_cdf.begin(), emission_cdf.end(), y) - emission_cdf.begin();
+        i = std::min(std::max(i, (size_t) 1), n-1);
+        const G4double f = (y - emission_cdf[i-1]) / (emission_cdf[i] - emission_cdf[i-1]);
+        const G4double e = spectrum->Energy(i-1) + f*(spectrum->Energy(i) - spectrum->Energy(i-1));
+        if (e <= e_max) return e;
+    }
+    return 0.0;
+}
+
+void TS01_FiberLightGuide::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+    Path path;
+    if (!Trace(fastTrack, path)) return;
+
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    const G4double e = track->GetKineticEnergy();
+
+    // Core bulk absorption and WLS re-absorption along the guided path;
+    // the cladding absorption is negligible for core-guided rays
+    enum { kGuided, kAbsorbed, kShifted } fate = kGuided;
+    G4double s = path.length;
+    const G4double abs_len = Property(path.core, "ABSLENGTH", e);
+    const G4double wls_len = Property(path.core, "WLSABSLENGTH", e);
+    if (abs_len > 0.0)
+    {
+        const G4double d = -abs_len*log(G4UniformRand());
+        if (d < s) { s = d; fate = kAbsorbed; }
+    }
+    if (wls_len > 0.0)
+    {
+        const G4double d = -wls_len*log(G4UniformRand());
+        if (d < s) { s = d; fate = kShifted; }
+    }
+
+    G4ThreeVector x = fastTrack.GetPrimaryTrackLocalPosition();
+    G4ThreeVector u = fastTrack.GetPrimaryTrackLocalDirection();
+    Propagate(path.core_r, s, x, u);
+
+    // Photon velocity in the core is the group velocity
+    const G4double t = track->GetGlobalTime() + s/track->GetVelocity();
+
+    fastStep.ProposePrimaryTrackPathLength(s);
+    fastStep.ProposePrimaryTrackFinalPosition(x);
+    fastStep.ProposePrimaryTrackFinalTime(t);
+    fastStep.ProposePrimaryTrackFinalProperTime(track->GetProperTime());
+
+    if (fate == kGuided)
+    {
+        // Keep the polarization transverse; TIR phase shifts are not followed
+        G4ThreeVector pol = fastTrack.GetPrimaryTrackLocalPolarization();
+        pol -= pol.dot(u)*u;
+        pol = pol.mag2() > 1.0e-12 ? pol.unit() : u.orthogonal().unit();
+        fastStep.ProposePrimaryTrackFinalMomentumDirection(u);
+        fastStep.ProposePrimaryTrackFinalPolarization(pol);
+        return;
+    }
+
+    fastStep.KillPrimaryTrack();
+    if (fate == kAbsorbed) return;
+
+    // Re-emission as G4OpWLS does it: WLSMEANNUMBERPHOTONS (default one)
+    // isotropic photons from WLSCOMPONENT, delayed by WLSTIMECONSTANT
+    G4MaterialPropertiesTable* mpt = path.core->GetMaterialPropertiesTable();
+    G4MaterialPropertyVector* spectrum = mpt->GetProperty("WLSCOMPONENT");
+    if (spectrum == NULL) return;
+
+    G4int n = 1;
+    if (mpt->ConstPropertyExists("WLSMEANNUMBERPHOTONS"))
+        n = G4Poisson(mpt->GetConstProperty("WLSMEANNUMBERPHOTONS"));
+    const G4double tau = mpt->ConstPropertyExists("WLSTIMECONSTANT") ?
+        mpt->GetConstProperty("WLSTIMECONSTANT") : 0.0;
+
+    std::vector<G4double> energies;
+    for (G4int i=0; i<n; i++)
+    {
+        const G4double e_wls = SampleEmission(spectrum, e);
+        if (e_wls > 0.0) energies.push_back(e_wls);
+    }
+
+    fastStep.SetNumberOfSecondaryTracks(energies.size());
+    for (size_t i=0; i<energies.size(); i++)
+    {
+        const G4double cost = 1.0 - 2.0*G4UniformRand();
+        const G4double sint = sqrt((1.0 - cost)*(1.0 + cost));
+        const G4double phi  = twopi*G4UniformRand();
+        const G4ThreeVector dir(sint*cos(phi), sint*sin(phi), cost);
+
+        G4ThreeVector pol = dir.orthogonal().unit();
+        pol.rotate(twopi*G4UniformRand(), dir);
+
+        G4DynamicParticle photon(G4OpticalPhoton::OpticalPhotonDefinition(), dir, energies[i]);
+        photon.SetPolarization(pol.x(), pol.y(), pol.z());
+        fastStep.CreateSecondaryTrack(photon, x, t - tau*log(G4UniformRand()));
+    }
+}
@@ -0,0 +1,25 @@
+//
+//  TS01_FiberRingParameterisation.cc
+//  ts_01
+//
+
+#include <math.h>
+
+#include "G4VPhysicalVolume.hh"
+#include "TS01_FiberRingParameterisation.hh"
+
+TS01_FiberRingParameterisation::TS01_FiberRingParameterisation(G4double r, G4int n) :
+    radius(r),
+    num_fiber(n)
+{
+
+}
+
+void TS01_FiberRingParameterisation::ComputeTransformation(const G4int copyNo,
+                                                           G4VPhysicalVolume* pv) const
+{
+    const double PI = 2.0 * std::acos(0.0);
+    const double phi = 2.*PI/num_fiber*copyNo;
+    pv->SetTranslation(G4ThreeVector(radius*cos(phi), radius*sin(phi), 0.0));
+    pv->SetRotation(NULL);
+}
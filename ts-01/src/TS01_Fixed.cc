@@ -0,0 +1,112 @@
+//
+//  TS01_Fixed.cc
+//  ts_01
+//
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "TS01_Fixed.hh"
+
+namespace
+{
+    __extension__ typedef unsigned __int128 UInt;
+
+    // Decimals written: 10^-15 / 2 is well below 2^-48 / 2
+    const G4int    kDecimals = 15;
+    const uint64_t kPow10    = 1000000000000000ULL;
+}
+
+TS01_Fixed::Int TS01_Fixed::OutOfRange(G4double x)
+{
+    G4ExceptionDescription msg;
+    msg << "Term " << x << " out of the fixed-point range, not added";
+    G4Exception("TS01_Fixed::Round", "TS01_Fixed001", JustWarning, msg);
+    return 0;
+}
+
+void TS01_Fixed::Overflow() const
+{
+    G4ExceptionDescription msg;
+    msg << "Fixed-point sum " << *this << " would overflow, term not added";
+    G4Exception("TS01_Fixed::Add", "TS01_Fixed002", JustWarning, msg);
+}
+
+std::ostream& operator<<(std::ostream& os, const TS01_Fixed& f)
+{
+    UInt u = f.value < 0 ? -f.value : f.value;
+    const UInt mask = ((UInt) 1 << TS01_Fixed::kBits) - 1;
+
+    // Nearest 10^-15, below 1 as the fraction is at most 1 - 2^-48
+    const uint64_t fraction = (uint64_t)
+        (((u & mask) * kPow10 + ((UInt) 1 << (TS01_Fixed::kBits - 1))) >> TS01_Fixed::kBits);
+
+    char digits[48];
+    char* p = digits + sizeof(digits);
+    *--p = '\0';
+    u >>= TS01_Fixed::kBits;
+    do
+    {
+        *--p = '0' + (char) (u % 10);
+        u /= 10;
+    } while (u != 0);
+
+    std::string s = f.value < 0 ? "-" : "";
+    s += p;
+    if (fraction != 0)
+    {
+        char decimals[20];
+        snprintf(decimals, sizeof(decimals), "%0*llu", kDecimals, (unsigned long long) fraction);
+        G4int n = kDecimals;
+        while (decimals[n-1] == '0') n--;
+        s += ".";
+        s.append(decimals, n);
+    }
+    return os << s;
+}
+
+std::istream& operator>>(std::istream& is, TS01_Fixed& f)
+{
+    std::string s;
+    if (!(is >> s)) return is;
+
+    // [-]digits[.decimals], as written by operator<<
+    size_t i = 0;
+    const G4bool negative = s[0] == '-';
+    if (negative) i++;
+    UInt u = 0;
+    G4bool ok = i < s.size() && isdigit(s[i]);
+    for (; ok && i < s.size() && isdigit(s[i]); i++)
+    {
+        u = u * 10 + (s[i] - '0');
+        ok = (u >> 78) == 0;
+    }
+    uint64_t fraction = 0;
+    if (ok && i < s.size() && s[i] == '.')
+    {
+        G4int n = 0;
+        for (i++; i < s.size() && isdigit(s[i]) && n < kDecimals; i++, n++)
+            fraction = fraction * 10 + (s[i] - '0');
+        for (; n < kDecimals; n++) fraction *= 10;
+    }
+    if (!ok || i != s.size())
+    {
+        is.setstate(std::ios::failbit);
+        return is;
+    }
+
+    // Back to the nearest 2^-48, which is the sum written
+    const UInt v = (u << TS01_Fixed::kBits) +
+        (((UInt) fraction << TS01_Fixed::kBits) + kPow10 / 2) / kPow10;
+    if ((v >> 126) != 0)
+    {
+        is.setstate(std::ios::failbit);
+        return is;
+    }
+    f.value = negative ? -(TS01_Fixed::Int) v : (TS01_Fixed::Int) v;
+    return is;
+}
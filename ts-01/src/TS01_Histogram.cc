@@ -0,0 +1,78 @@
+//
+//  TS01_Histogram.cc
+//  ts_01
+//
+
+#include <istream>
+#include <ostream>
+
+#include "TS01_Histogram.hh"
+
+TS01_Histogram::TS01_Histogram(const G4String& n, G4int nb, G4double l, G4double h) :
+    name(n)
+{
+    SetBinning(nb, l, h);
+}
+
+void TS01_Histogram::SetBinning(G4int nb, G4double l, G4double h)
+{
+    if (nb < 1 || !(h > l))
+    {
+        G4ExceptionDescription msg;
+        msg << "Bad binning for histogram " << name << ": "
+            << nb << " bins in [" << l << ", " << h << ")";
+        G4Exception("TS01_Histogram::SetBinning", "TS01_Histo001", JustWarning, msg);
+        return;
+    }
+    nbins = nb;
+    lo = l;
+    hi = h;
+    inv_width = nbins / (hi - lo);
+    counts.assign(nbins + 2, TS01_Fixed());
+    entries = 0;
+}
+
+void TS01_Histogram::Reset()
+{
+    counts.assign(nbins + 2, TS01_Fixed());
+    entries = 0;
+}
+
+G4bool TS01_Histogram::Merge(const TS01_Histogram& other)
+{
+    if (other.nbins != nbins || other.lo != lo || other.hi != hi)
+    {
+        G4ExceptionDescription msg;
+        msg << "Binning mismatch merging histogram " << name;
+        G4Exception("TS01_Histogram::Merge", "TS01_Histo002", JustWarning, msg);
+        return false;
+    }
+    for (G4int i=0; i<nbins+2; i++) counts[i] += other.counts[i];
+    entries += other.entries;
+    return true;
+}
+
+void TS01_Histogram::Write(std::ostream& os) const
+{
+    os << "histogram " << name << " " << nbins << " " << lo << " " << hi
+       << " " << entries << "\n";
+    // underflow, nbins bins, overflow
+    for (G4int i=0; i<nbins+2; i++)
+        os << counts[i] << ((i == nbins+1) ? "\n" : " ");
+}
+
+G4bool TS01_Histogram::Read(std::istream& is)
+{
+    G4String tag, n;
+    G4int    nb;
+    G4double l, h;
+    G4long   e;
+    if (!(is >> tag >> n >> nb >> l >> h >> e) || tag != "histogram" || nb < 1 || !(h > l))
+        return false;
+    
+    name = n;
+    SetBinning(nb, l, h);
+    entries = e;
+    for (G4int i=0; i<nbins+2; i++) is >> counts[i];
+    return !is.fail();
+}
@@ -0,0 +1,97 @@
+//
+//  TS01_HitWriter.cc
+//  ts_01
+//
+
+#include "TS01_HitWriter.hh"
+
+// 4 MB per thread keeps fwrite calls rare even on Cherenkov runs
+static const size_t HIT_BUFFER_SIZE = 4 << 20;
+
+TS01_HitWriter* TS01_HitWriter::Instance()
+{
+    static G4ThreadLocal TS01_HitWriter* instance = NULL;
+    if (instance == NULL) instance = new TS01_HitWriter;
+    return instance;
+}
+
+TS01_HitWriter::TS01_HitWriter() :
+    fp(NULL),
+    fill(0),
+    header_offset(-1),
+    n_records(0),
+    text_echo(false)
+{
+    memset(&header, 0, sizeof(header));
+}
+
+TS01_HitWriter::~TS01_HitWriter()
+{
+    Close();
+}
+
+void TS01_HitWriter::Open(const G4String& file_name)
+{
+    if (fp != NULL && file_name == name) return;
+    Close();
+    
+    fp = fopen(file_name.c_str(), "wb");
+    if (fp == NULL)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot open hit file " << file_name;
+        G4Exception("TS01_HitWriter::Open", "TS01_Output001", JustWarning, msg);
+        return;
+    }
+    name = file_name;
+    buffer.resize(HIT_BUFFER_SIZE);
+    fill = 0;
+}
+
+void TS01_HitWriter::Close()
+{
+    if (fp == NULL) return;
+    EndRun();
+    fclose(fp);
+    fp = NULL;
+    name = "";
+    std::vector<char>().swap(buffer);
+}
+
+void TS01_HitWriter::BeginRun(const TS01_HitFileHeader& h)
+{
+    if (fp == NULL) return;
+    EndRun();
+    
+    header = h;
+    memcpy(header.magic, "TS01HIT", 8);
+    header.version     = version;
+    header.record_size = sizeof(TS01_HitRecord);
+    header.n_records   = 0;
+    n_records = 0;
+    
+    Flush();
+    header_offset = ftell(fp);
+    fwrite(&header, sizeof(header), 1, fp);
+}
+
+void TS01_HitWriter::EndRun()
+{
+    if (fp == NULL || header_offset < 0) return;
+    Flush();
+    
+    // Patch the record count of this run's block
+    header.n_records = n_records;
+    long end = ftell(fp);
+    fseek(fp, header_offset, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fp);
+    fseek(fp, end, SEEK_SET);
+    fflush(fp);
+    header_offset = -1;
+}
+
+void TS01_HitWriter::Flush()
+{
+    if (fp != NULL && fill > 0) fwrite(&buffer[0], 1, fill, fp);
+    fill = 0;
+}
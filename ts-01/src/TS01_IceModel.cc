@@ -0,0 +1,130 @@
+//
+//  TS01_IceModel.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <fstream>
+#include <sstream>
+
+#include "G4SystemOfUnits.hh"
+#include "TS01_IceModel.hh"
+
+TS01_IceModel* TS01_IceModel::Instance()
+{
+    static TS01_IceModel* instance = NULL;
+    if (instance == NULL) instance = new TS01_IceModel;
+    return instance;
+}
+
+TS01_IceModel::TS01_IceModel() :
+    material(NULL),
+    g(0.9), alpha(0.898), kappa(1.084),
+    z0(0.0), inv_dz(0.0), top_layer(0.0)
+{
+
+}
+
+G4bool TS01_IceModel::Load(const G4String& file)
+{
+    std::ifstream is(file.c_str());
+    if (!is)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot read ice model " << file;
+        G4Exception("TS01_IceModel::Load", "TS01_IceModel001", JustWarning, msg);
+        return false;
+    }
+
+    G4double bottom = 0.0, dz = 0.0;
+    std::vector<G4double> b, a;
+    G4bool ok = true;
+    std::string line;
+    while (ok && std::getline(is, line))
+    {
+        const std::string text = line.substr(0, line.find('#'));
+        std::istringstream ls(text);
+        G4String key;
+        if (!(ls >> key)) continue;
+
+        if (key == "g")           ok = (G4bool) (ls >> g) && g > -1.0 && g < 1.0;
+        else if (key == "alpha")  ok = (G4bool) (ls >> alpha);
+        else if (key == "kappa")  ok = (G4bool) (ls >> kappa);
+        else if (key == "layers") ok = (G4bool) (ls >> bottom >> dz) && dz > 0.0;
+        else
+        {
+            std::istringstream row(text);
+            G4double b_e, a_400;
+            ok = dz > 0.0 && (row >> b_e >> a_400) && b_e >= 0.0 && a_400 >= 0.0;
+            b.push_back(b_e);
+            a.push_back(a_400);
+        }
+    }
+    if (!ok || b.empty())
+    {
+        G4ExceptionDescription msg;
+        if (ok)
+            msg << "Ice model " << file << " has no layers";
+        else
+            msg << "Ice model " << file << " is not valid at \"" << line << "\"";
+        G4Exception("TS01_IceModel::Load", "TS01_IceModel002", JustWarning, msg);
+        return false;
+    }
+    scattering.resize(b.size());
+    absorption.resize(a.size());
+    for (size_t i=0; i<b.size(); i++)
+    {
+        scattering[i] = b[i] / (1.0 - g) / m;
+        absorption[i] = a[i] / m;
+    }
+    z0        = bottom * m;
+    inv_dz    = 1.0 / (dz * m);
+    top_layer = scattering.size() - 1;
+
+    // Wavelength scales over the optical photon range, (wl/400 nm)^-x = (e/e_400)^x
+    const G4double e_low = 1.5*eV, e_high = 6.5*eV;
+    const G4double e_400 = 1239.84193*eV / 400.0;
+    std::vector<G4double> s(kEnergyBins + 1), t(kEnergyBins + 1);
+    for (G4int i=0; i<=kEnergyBins; i++)
+    {
+        const G4double e = e_low + (e_high - e_low) * i / kEnergyBins;
+        s[i] = pow(e / e_400, alpha);
+        t[i] = pow(e / e_400, kappa);
+    }
+    scattering_scale.Fill(e_low, e_high, s);
+    absorption_scale.Fill(e_low, e_high, t);
+
+    // HG: cos(theta) = (1 + g^2 - ((1 - g^2) / (1 - g + 2 g u))^2) / 2g
+    cos_theta.resize(kAngleBins + 2);
+    for (G4int i=0; i<=kAngleBins; i++)
+    {
+        const G4double u = (G4double) i / kAngleBins;
+        if (fabs(g) < 1e-6)
+            cos_theta[i] = 2.0*u - 1.0;
+        else
+        {
+            const G4double q = (1.0 - g*g) / (1.0 - g + 2.0*g*u);
+            cos_theta[i] = std::min(1.0, std::max(-1.0, (1.0 + g*g - q*q) / (2.0*g)));
+        }
+    }
+    cos_theta[kAngleBins + 1] = cos_theta[kAngleBins];
+
+    G4cout << "TS01_IceModel: " << scattering.size() << " layers of " << dz << " m from "
+           << bottom << " m, g " << g << ", alpha " << alpha << ", kappa " << kappa
+           << " (" << file << ")" << G4endl;
+    return true;
+}
+
+void TS01_IceModel::Describe(std::ostream& os) const
+{
+    if (!IsLoaded())
+    {
+        os << "layers none\n";
+        return;
+    }
+    const std::streamsize precision = os.precision(17);
+    os << "g " << g << " alpha " << alpha << " kappa " << kappa << "\n"
+       << "layers " << z0 << " " << 1.0 / inv_dz << "\n";
+    for (size_t i=0; i<scattering.size(); i++) os << scattering[i] << " " << absorption[i] << "\n";
+    os.precision(precision);
+}
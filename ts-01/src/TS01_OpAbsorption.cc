@@ -0,0 +1,33 @@
+//
+//  TS01_OpAbsorption.cc
+//  ts_01
+//
+
+#include <float.h>
+
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Material.hh"
+#include "TS01_OpticalCache.hh"
+#include "TS01_IceModel.hh"
+#include "TS01_OpAbsorption.hh"
+
+TS01_OpAbsorption::TS01_OpAbsorption(const G4String& name) :
+    G4OpAbsorption(name),
+    cache(TS01_OpticalCache::Instance()->IsEnabled() ? TS01_OpticalCache::Instance() : NULL),
+    ice_model(TS01_IceModel::Instance())
+{
+
+}
+
+G4double TS01_OpAbsorption::GetMeanFreePath(const G4Track& track, G4double previous,
+                                            G4ForceCondition* condition)
+{
+    const G4Material* material = track.GetMaterial();
+    if (material == ice_model->GetMaterial()) return DBL_MAX;
+    if (cache == NULL) return G4OpAbsorption::GetMeanFreePath(track, previous, condition);
+    
+    // No ABSLENGTH means no absorption, as in G4OpAbsorption
+    const TS01_OpticalTable* table = cache->Get(material->GetIndex(), TS01_OpticalCache::kAbsLength);
+    return table ? table->Value(track.GetDynamicParticle()->GetTotalMomentum()) : DBL_MAX;
+}
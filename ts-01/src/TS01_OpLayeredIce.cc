@@ -0,0 +1,117 @@
+//
+//  TS01_OpLayeredIce.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4DynamicParticle.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include "TS01_IceModel.hh"
+#include "TS01_OpLayeredIce.hh"
+
+TS01_OpLayeredIce::TS01_OpLayeredIce(const G4String& name) :
+    G4VDiscreteProcess(name, fOptical),
+    model(TS01_IceModel::Instance()),
+    optical_depth(-1.0),
+    step_mfp(0.0),
+    at_layer(false),
+    scattering(0.0), absorption(0.0)
+{
+
+}
+
+G4bool TS01_OpLayeredIce::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+void TS01_OpLayeredIce::StartTracking(G4Track* track)
+{
+    G4VDiscreteProcess::StartTracking(track);
+    optical_depth = -1.0;
+    step_mfp = 0.0;
+    at_layer = false;
+}
+
+G4double TS01_OpLayeredIce::GetMeanFreePath(const G4Track& track, G4double, G4ForceCondition*)
+{
+    if (track.GetMaterial() != model->GetMaterial()) return DBL_MAX;
+    const G4int    layer = model->Layer(track.GetPosition().z());
+    const G4double e     = track.GetDynamicParticle()->GetTotalMomentum();
+    return 1.0 / (model->GetScattering(layer, e) + model->GetAbsorption(layer, e));
+}
+
+G4double TS01_OpLayeredIce::PostStepGetPhysicalInteractionLength(const G4Track& track,
+                                                                 G4double previous,
+                                                                 G4ForceCondition* condition)
+{
+    *condition = NotForced;
+    
+    // The last step stayed in one layer, so it used up previous / mfp
+    if (step_mfp > 0.0) optical_depth -= previous / step_mfp;
+    step_mfp = 0.0;
+    at_layer = false;
+    if (track.GetMaterial() != model->GetMaterial()) return DBL_MAX;
+    
+    if (optical_depth <= 0.0) optical_depth = -log(G4UniformRand());
+    
+    // On a boundary the layer ahead counts
+    const G4double z  = track.GetPosition().z();
+    const G4double uz = track.GetMomentumDirection().z();
+    const G4double kNudge = 1e-9*m;
+    const G4int layer = model->Layer(uz > 0.0 ? z + kNudge : (uz < 0.0 ? z - kNudge : z));
+    
+    const G4double e = track.GetDynamicParticle()->GetTotalMomentum();
+    scattering = model->GetScattering(layer, e);
+    absorption = model->GetAbsorption(layer, e);
+    step_mfp   = 1.0 / (scattering + absorption);
+    
+    // Distance to the layer boundary ahead; the outermost layers extend
+    // to infinity
+    G4double to_layer = DBL_MAX;
+    if (uz > 0.0 && layer < model->GetNumberOfLayers() - 1)
+        to_layer = (model->GetLayerBottom(layer + 1) - z) / uz;
+    else if (uz < 0.0 && layer > 0)
+        to_layer = (model->GetLayerBottom(layer) - z) / uz;
+    
+    const G4double to_interaction = optical_depth * step_mfp;
+    at_layer = to_layer < to_interaction;
+    return at_layer ? std::max(to_layer, 0.0) : to_interaction;
+}
+
+G4VParticleChange* TS01_OpLayeredIce::PostStepDoIt(const G4Track& track, const G4Step&)
+{
+    aParticleChange.Initialize(track);
+    if (at_layer) return &aParticleChange;
+    
+    optical_depth = -1.0;
+    step_mfp = 0.0;
+    if (G4UniformRand() * (scattering + absorption) < absorption)
+    {
+        aParticleChange.ProposeTrackStatus(fStopAndKill);
+        return &aParticleChange;
+    }
+    
+    const G4double cos_theta = model->SampleCosTheta(G4UniformRand());
+    const G4double sin_theta = sqrt(std::max(0.0, 1.0 - cos_theta*cos_theta));
+    const G4double phi       = twopi * G4UniformRand();
+    const G4ThreeVector& old_dir = track.GetMomentumDirection();
+    G4ThreeVector dir(sin_theta*cos(phi), sin_theta*sin(phi), cos_theta);
+    dir.rotateUz(old_dir);
+    
+    // Keep the polarisation transverse, as close to the old one as possible
+    G4ThreeVector pol = track.GetPolarization() - dir * dir.dot(track.GetPolarization());
+    pol = pol.mag2() > 1e-12 ? pol.unit() : dir.orthogonal().unit();
+    
+    aParticleChange.ProposeMomentumDirection(dir);
+    aParticleChange.ProposePolarization(pol);
+    return &aParticleChange;
+}
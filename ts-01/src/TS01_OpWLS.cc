@@ -0,0 +1,26 @@
+//
+//  TS01_OpWLS.cc
+//  ts_01
+//
+
+#include <float.h>
+
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Material.hh"
+#include "TS01_OpticalCache.hh"
+#include "TS01_OpWLS.hh"
+
+TS01_OpWLS::TS01_OpWLS(const G4String& name) :
+    G4OpWLS(name),
+    cache(TS01_OpticalCache::Instance())
+{
+
+}
+
+G4double TS01_OpWLS::GetMeanFreePath(const G4Track& track, G4double, G4ForceCondition*)
+{
+    const TS01_OpticalTable* table = cache->Get(track.GetMaterial()->GetIndex(),
+                                                TS01_OpticalCache::kWLSAbsLength);
+    return table ? table->Value(track.GetDynamicParticle()->GetTotalMomentum()) : DBL_MAX;
+}
@@ -0,0 +1,188 @@
+//
+//  TS01_OpticalCache.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <stdint.h>
+#include <chrono>
+
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "TS01_OpticsMessenger.hh"
+#include "TS01_OpticalCache.hh"
+
+namespace
+{
+    G4double Now()
+    {
+        return std::chrono::duration<G4double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Benchmark energies in [0, 1), independent of the event random engine
+    G4double Uniform(uint64_t& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Mean time per lookup [ns] and the sum of the values, so the loops
+    // cannot be optimised away and both sides can be compared
+    template <class T>
+    G4double TimeLookups(const T& table, const std::vector<G4double>& e, G4double& sum)
+    {
+        const G4double t0 = Now();
+        G4double s = 0.0;
+        for (size_t i=0; i<e.size(); i++) s += table.Value(e[i]);
+        sum = s;
+        return (Now() - t0) / e.size() * 1e9;
+    }
+}
+
+void TS01_OpticalTable::Fill(const G4MaterialPropertyVector* mpv, G4int min_bins)
+{
+    const size_t n = mpv->GetVectorLength();
+    v.clear();
+    if (n == 0) return;
+
+    const G4double e_low  = mpv->Energy(0);
+    const G4double e_high = mpv->Energy(n - 1);
+    G4int bins = 1;
+    if (n > 1 && e_high > e_low)
+        bins = (n - 1) * ((min_bins + n - 2) / (n - 1));
+
+    std::vector<G4double> values(bins + 1);
+    for (G4int i=0; i<=bins; i++) values[i] = mpv->Value(e_low + (e_high - e_low) * i / bins);
+    Fill(e_low, e_high, values);
+
+    deviation = 0.0;
+    for (G4int i=0; i<bins; i++)
+    {
+        const G4double e   = e_low + (e_high - e_low) * (i + 0.5) / bins;
+        const G4double ref = mpv->Value(e);
+        if (ref != 0.0) deviation = std::max(deviation, fabs(Value(e) / ref - 1.0));
+    }
+}
+
+void TS01_OpticalTable::Fill(G4double e_low, G4double e_high, const std::vector<G4double>& values)
+{
+    const G4int bins = values.size() - 1;
+    e0     = e_low;
+    inv_de = e_high > e_low ? bins / (e_high - e_low) : 0.0;
+    top    = bins;
+    deviation = 0.0;
+    v = values;
+    // Repeated so Value() can always read [j+1]
+    v.push_back(values.back());
+}
+
+TS01_OpticalCache* TS01_OpticalCache::Instance()
+{
+    static TS01_OpticalCache* instance = NULL;
+    if (instance == NULL) instance = new TS01_OpticalCache;
+    return instance;
+}
+
+TS01_OpticalCache::TS01_OpticalCache() :
+    enabled(false)
+{
+    messenger = new TS01_OpticsMessenger(this);
+}
+
+const char* TS01_OpticalCache::PropertyName(G4int property)
+{
+    static const char* names[kNumProperties] = { "RINDEX", "ABSLENGTH", "WLSABSLENGTH" };
+    return names[property];
+}
+
+void TS01_OpticalCache::Build()
+{
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    tables.assign(materials->size() * kNumProperties, TS01_OpticalTable());
+
+    G4int n = 0;
+    for (size_t m=0; m<materials->size(); m++)
+    {
+        G4MaterialPropertiesTable* mpt = (*materials)[m]->GetMaterialPropertiesTable();
+        if (mpt == NULL) continue;
+        for (G4int p=0; p<kNumProperties; p++)
+        {
+            const G4MaterialPropertyVector* mpv = mpt->GetProperty(PropertyName(p));
+            if (mpv == NULL) continue;
+            tables[(*materials)[m]->GetIndex() * kNumProperties + p].Fill(mpv, kMinBins);
+            n++;
+        }
+    }
+    G4cout << "TS01_OpticalCache: " << n << " optical property tables on uniform grids" << G4endl;
+}
+
+void TS01_OpticalCache::List() const
+{
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    for (size_t m=0; m<materials->size(); m++)
+    {
+        for (G4int p=0; p<kNumProperties; p++)
+        {
+            const TS01_OpticalTable* t = Get((*materials)[m]->GetIndex(), p);
+            if (t == NULL) continue;
+            G4cout << "  " << (*materials)[m]->GetName() << " " << PropertyName(p) << ": "
+                   << t->GetLowEnergy() / eV << "-" << t->GetHighEnergy() / eV << " eV, "
+                   << t->GetBins() << " bins, max. relative deviation "
+                   << t->GetDeviation() << G4endl;
+        }
+    }
+}
+
+void TS01_OpticalCache::Benchmark(G4int n) const
+{
+    // Random energies defeat the Geant4 last-bin cache; tracking looks up
+    // the same energy for every step of a photon, so the repeated pattern
+    // (8 lookups per energy) is closer to the best case for Geant4
+    const G4int kRepeat = 8;
+    uint64_t state = 0x5DEECE66DULL;
+
+    G4cout << "TS01_OpticalCache: " << n << " lookups per table [ns/lookup]"
+           << "\n  material property: Geant4 / cache random, Geant4 / cache repeated" << G4endl;
+
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    for (size_t m=0; m<materials->size(); m++)
+    {
+        const G4Material* mat = (*materials)[m];
+        G4MaterialPropertiesTable* mpt = mat->GetMaterialPropertiesTable();
+        G4double step_g4 = 0.0, step_cache = 0.0;
+        for (G4int p=0; p<kNumProperties; p++)
+        {
+            const TS01_OpticalTable* t = Get(mat->GetIndex(), p);
+            if (t == NULL) continue;
+            const G4MaterialPropertyVector* mpv = mpt->GetProperty(PropertyName(p));
+
+            std::vector<G4double> random(n), repeated(n);
+            const G4double e0 = t->GetLowEnergy(), e1 = t->GetHighEnergy();
+            for (G4int i=0; i<n; i++) random[i] = e0 + (e1 - e0) * Uniform(state);
+            for (G4int i=0; i<n; i++) repeated[i] = random[i / kRepeat];
+
+            G4double sum_g4, sum_cache;
+            const G4double g4_random    = TimeLookups(*mpv, random, sum_g4);
+            const G4double cache_random = TimeLookups(*t, random, sum_cache);
+            const G4double g4_repeated    = TimeLookups(*mpv, repeated, sum_g4);
+            const G4double cache_repeated = TimeLookups(*t, repeated, sum_cache);
+
+            G4cout << "  " << mat->GetName() << " " << PropertyName(p) << ": "
+                   << g4_random << " / " << cache_random << ", "
+                   << g4_repeated << " / " << cache_repeated
+                   << " (mean " << sum_g4 / n << " / " << sum_cache / n << ")" << G4endl;
+
+            // Each step asks every discrete process for its mean free path
+            if (p != kRindex)
+            {
+                step_g4    += g4_repeated;
+                step_cache += cache_repeated;
+            }
+        }
+        if (step_g4 > 0.0)
+            G4cout << "  " << mat->GetName() << " per step: " << step_g4 << " -> "
+                   << step_cache << " ns" << G4endl;
+    }
+}
@@ -0,0 +1,46 @@
+//
+//  TS01_OpticsMessenger.cc
+//  ts_01
+//
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "TS01_OpticalCache.hh"
+#include "TS01_OpticsMessenger.hh"
+
+TS01_OpticsMessenger::TS01_OpticsMessenger(TS01_OpticalCache* c) :
+    cache(c)
+{
+    optics_dir = new G4UIdirectory("/ts01/optics/", false);
+    optics_dir->SetGuidance("Optical property tables on uniform energy grids (--optics-cache).");
+
+    list_cmd = new G4UIcmdWithoutParameter("/ts01/optics/list", this);
+    list_cmd->SetGuidance("List the cached tables and their largest deviation from Geant4.");
+    list_cmd->AvailableForStates(G4State_Idle);
+    list_cmd->SetToBeBroadcasted(false);
+
+    bench_cmd = new G4UIcmdWithAnInteger("/ts01/optics/benchmark", this);
+    bench_cmd->SetGuidance("Time <n> lookups per table through the Geant4 property vectors");
+    bench_cmd->SetGuidance("and through the cache, and the mean free path lookups per step.");
+    bench_cmd->SetParameterName("n", true);
+    bench_cmd->SetDefaultValue(1000000);
+    bench_cmd->SetRange("n > 0");
+    bench_cmd->AvailableForStates(G4State_Idle);
+    bench_cmd->SetToBeBroadcasted(false);
+}
+
+TS01_OpticsMessenger::~TS01_OpticsMessenger()
+{
+    delete bench_cmd;
+    delete list_cmd;
+    delete optics_dir;
+}
+
+void TS01_OpticsMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    if (cmd == list_cmd)
+        cache->List();
+    else if (cmd == bench_cmd)
+        cache->Benchmark(G4UIcmdWithAnInteger::GetNewIntValue(value));
+}
@@ -0,0 +1,15 @@
+//
+//  TS01_PhotoHit.cc
+//  ts_01
+//
+
+#include "G4SystemOfUnits.hh"
+#include "TS01_PhotoHit.hh"
+
+G4ThreadLocal G4Allocator<TS01_PhotoHit>* TS01_PhotoHitAllocator = NULL;
+
+void TS01_PhotoHit::Print()
+{
+    G4cout << "channel " << channel << ": " << photons << " photons, "
+           << weighted << " weighted, first at " << first_time / ns << " ns" << G4endl;
+}
@@ -8,24 +8,26 @@
 
 #include <stdio.h>
 
+#include "G4RunManager.hh"
+#include "G4EventManager.hh"
+#include "G4SDManager.hh"
+#include "TS01_Checkpoint.hh"
+#include "TS01_Telemetry.hh"
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_HitWriter.hh"
+#include "TS01_SpectralResponse.hh"
 #include "TS01_PhotoSD.hh"
-
-// Bialkali PMT QE starts at 300 nm goes to 690 nm in steps of 10 n,
-static G4double QE[] = {
-    1.773,  6.173,  11.074, 16.593, 20.03,  // 300 nm .. 340 nm
-    22.368, 23.366, 24.242, 24.39 , 24.843, // 350 nm .. 390 nm
-    24.969, 25.323, 24.879, 23.809, 22.959, // 400 nm .. 440 nm
-    22.204, 21.097, 19.572, 18.351, 17.425, // 450 nm .. 490 nm
-    16.655, 15.647, 13.518, 10.752,  8.71,  // 500 nm .. 540 nm
-    7.473 ,  6.587,  5.736,  4.906,  4.067, // 550 nm .. 590 nm
-    3.289 ,  2.553,  1.878,  1.211,  0.835, // 600 nm .. 640 nm
-    0.533 ,  0.304,  0.175,  0.093,  0.048  // 650 nm .. 690 nm
-};
+#include "TS01_Run.hh"
+#include "TS01_StackingAction.hh"
 
 TS01_PhotoSD::TS01_PhotoSD(const G4String& name, const G4String& hitsCollectionName) :
-    G4VSensitiveDetector(name)
+    G4VSensitiveDetector(name),
+    channel_depth(0),
+    n_buffers(0),
+    hits(NULL),
+    hc_id(-1)
 {
-    
+    collectionName.insert(hitsCollectionName);
 }
 
 TS01_PhotoSD::~TS01_PhotoSD() { }
@@ -34,6 +36,43 @@ void TS01_PhotoSD::Initialize(G4HCofThisEvent *hitCollection)
 {
     unweighted_hits = 0.0;
     weighted_hits = 0.0;
+    event_id = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+    
+    // Thread-local run; merged into the master run at end of run
+    run = static_cast<TS01_Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    
+    // Per-channel hits; the collection is owned and deleted by the event
+    hits = new TS01_PhotoHitsCollection(SensitiveDetectorName, collectionName[0]);
+    if (hc_id < 0) hc_id = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+    hitCollection->AddHitsCollection(hc_id, hits);
+    std::fill(channel_hit.begin(), channel_hit.end(), -1);
+    
+    stacking = static_cast<const TS01_StackingAction*>(
+        G4RunManager::GetRunManager()->GetUserStackingAction());
+    
+    // Volumes and response assignments may change between events
+    for (size_t i=0; i<n_buffers; i++)
+    {
+        buffers[i].wl.clear();
+        buffers[i].channel.clear();
+        buffers[i].track_weight.clear();
+    }
+    n_buffers = 0;
+}
+
+TS01_PhotoSD::HitBuffer& TS01_PhotoSD::Buffer(const G4LogicalVolume* volume)
+{
+    for (size_t i=0; i<n_buffers; i++)
+        if (buffers[i].volume == volume) return buffers[i];
+    
+    if (n_buffers == buffers.size()) buffers.push_back(HitBuffer());
+    HitBuffer& b = buffers[n_buffers++];
+    
+    const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    b.volume   = volume;
+    b.response = det->GetVolumeResponse(volume->GetName());
+    return b;
 }
 
 G4bool TS01_PhotoSD::ProcessHits(G4Step *step, G4TouchableHistory *history)
@@ -41,17 +80,82 @@ G4bool TS01_PhotoSD::ProcessHits(G4Step *step, G4TouchableHistory *history)
     G4double p = step->GetTrack()->GetKineticEnergy();
     G4double wl = 1240.0 / p * CLHEP::eV;
     G4StepPoint* post = step->GetPostStepPoint();
-    G4cout << "SD-S " << post->GetGlobalTime() << " " << wl << G4endl;
-    unweighted_hits++;
-    if (wl >= 300.0 && wl < 700.0)
+    const G4VTouchable* touchable = step->GetPreStepPoint()->GetTouchable();
+    const G4int channel = touchable->GetCopyNumber(channel_depth);
+    
+    TS01_HitWriter* writer = TS01_HitWriter::Instance();
+    if (writer->IsActive())
     {
-        int iw = (int) ((wl - 300.0) / 10.0);
-        weighted_hits += QE[iw]*0.01;
+        const G4ThreeVector& x = post->GetPosition();
+        const G4ThreeVector& u = post->GetMomentumDirection();
+        TS01_HitRecord r;
+        r.event      = event_id;
+        r.channel    = channel;
+        r.time       = post->GetGlobalTime() / CLHEP::ns;
+        r.wavelength = wl;
+        r.pos[0] = x.x() / CLHEP::mm; r.pos[1] = x.y() / CLHEP::mm; r.pos[2] = x.z() / CLHEP::mm;
+        r.dir[0] = u.x();             r.dir[1] = u.y();             r.dir[2] = u.z();
+        r.weight     = step->GetTrack()->GetWeight();
+        writer->Write(r);
     }
+    
+    // A hit from a photon the stacking action would have culled means the
+    // culling changes SD-W; only possible in validation mode
+    if (stacking && stacking->IsCulled(step->GetTrack()->GetTrackID()))
+        run->CountCull(TS01_Run::kCullDetected);
+    
+    // Owned by the track from here
+    G4Track* track = step->GetTrack();
+    if (track->GetUserInformation() == NULL) track->SetUserInformation(new Detected);
+    
+    // Super-photons count for as many photons as their weight
+    const G4double w = track->GetWeight();
+    unweighted_hits += w;
+    run->AddHit(post->GetGlobalTime() / CLHEP::ns, wl, w);
+    Hit(channel)->AddPhoton(post->GetGlobalTime(), w);
+    
+    HitBuffer& buffer = Buffer(touchable->GetVolume()->GetLogicalVolume());
+    buffer.wl.push_back(wl);
+    buffer.channel.push_back(channel);
+    buffer.track_weight.push_back(w);
     return true;
 }
 
+void TS01_PhotoSD::AddExpected(G4double unweighted, G4double weighted)
+{
+    unweighted_hits += unweighted;
+    weighted_hits   += weighted;
+}
+
 void TS01_PhotoSD::EndOfEvent(G4HCofThisEvent *hitCollection)
 {
+    // Past the end of this job's event range (TS01_Shard), or already in
+    // the resumed checkpoint
+    if (G4EventManager::GetEventManager()->GetConstCurrentEvent()->IsAborted()) return;
+    
+    for (size_t b=0; b<n_buffers; b++)
+    {
+        const HitBuffer& buffer = buffers[b];
+        const size_t n = buffer.wl.size();
+        if (n == 0) continue;
+        weights.resize(n);
+        buffer.response->Weight(n, &buffer.wl[0], &buffer.channel[0], &weights[0]);
+        for (size_t i=0; i<n; i++)
+        {
+            const G4double w = weights[i] * buffer.track_weight[i];
+            weighted_hits += w;
+            Hit(buffer.channel[i])->AddWeight(w);
+        }
+    }
+    
+    for (size_t i=0; i<hits->entries(); i++)
+    {
+        const TS01_PhotoHit* hit = (*hits)[i];
+        run->AddChannel(hit->GetChannel(), hit->GetPhotons(), hit->GetWeighted());
+    }
+    
     G4cout << "SD-W " << unweighted_hits << " " << weighted_hits << G4endl;
+    run->AddEvent(event_id, unweighted_hits, weighted_hits);
+    TS01_Telemetry::Instance()->EndOfEvent(unweighted_hits, weighted_hits);
+    TS01_Checkpoint::Instance()->EndOfEvent(event_id, run);
 }
\ No newline at end of file
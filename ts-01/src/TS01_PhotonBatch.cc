@@ -0,0 +1,186 @@
+//
+//  TS01_PhotonBatch.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <algorithm>
+
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "TS01_SensorBounds.hh"
+#include "TS01_AcceptanceTable.hh"
+#include "TS01_PhotonBatch.hh"
+
+namespace
+{
+    // Kernel passes over one range of the photon arrays; restrict on the
+    // arguments lets the compiler vectorise without run-time alias checks
+    
+    // Free path in absorption lengths: splitmix64 finaliser of (event key,
+    // track ID) as a uniform number in (0, 1]
+    void FreePath(size_t n, uint64_t key, const G4int* __restrict id, G4double* __restrict s)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            uint64_t k = key + 0x9E3779B97F4A7C15ULL * (uint64_t) (id[i] + 1);
+            k = (k ^ (k >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            k = (k ^ (k >> 27)) * 0x94D049BB133111EBULL;
+            k =  k ^ (k >> 31);
+            s[i] = -log(((k >> 11) + 1) * (1.0 / 9007199254740992.0));
+        }
+    }
+    
+    // Free path to length, and inverse group velocity, on the uniform grid
+    void IceLookup(size_t n, G4double e0, G4double inv_de, G4double top,
+                   const G4double* __restrict abl, const G4double* __restrict igv,
+                   const G4double* __restrict e, G4double* __restrict s, G4double* __restrict iv)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            const G4double f = std::min(std::max((e[i] - e0) * inv_de, 0.0), top);
+            const G4int    j = (G4int) f;
+            const G4double w = f - j;
+            s[i] *= abl[j] + w*(abl[j+1] - abl[j]);
+            iv[i] = igv[j] + w*(igv[j+1] - igv[j]);
+        }
+    }
+    
+    // Exponential absorption is memoryless, so Geant4 samples afresh from
+    // where the photon is handed back
+    void Advance(size_t n, const G4double* __restrict d, const G4double* __restrict s,
+                 const G4double* __restrict iv, const G4double* __restrict ux,
+                 const G4double* __restrict uy, const G4double* __restrict uz,
+                 G4double* __restrict x, G4double* __restrict y, G4double* __restrict z,
+                 G4double* __restrict t, G4int* __restrict alive)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            const G4bool   hit  = (d[i] >= 0.0) && (s[i] >= d[i]);
+            const G4double move = hit ? d[i] : 0.0;
+            alive[i] = hit;
+            x[i] += move * ux[i];
+            y[i] += move * uy[i];
+            z[i] += move * uz[i];
+            t[i] += move * iv[i];
+        }
+    }
+}
+
+TS01_PhotonBatch::TS01_PhotonBatch() :
+    event_key(0),
+    ice_e0(0.0),
+    ice_inv_de(0.0)
+{
+    
+}
+
+G4bool TS01_PhotonBatch::LoadIce()
+{
+    G4Material* ice = G4Material::GetMaterial("Ice");
+    G4MaterialPropertiesTable* mpt = ice ? ice->GetMaterialPropertiesTable() : NULL;
+    G4MaterialPropertyVector* abs = mpt ? mpt->GetProperty("ABSLENGTH") : NULL;
+    if (abs == NULL || abs->GetVectorLength() < 2)
+    {
+        G4ExceptionDescription msg;
+        msg << "Ice has no ABSLENGTH table, sub-event propagation disabled";
+        G4Exception("TS01_PhotonBatch::LoadIce", "TS01_PhotonBatch001", JustWarning, msg);
+        return false;
+    }
+    G4MaterialPropertyVector* groupvel = mpt->GetProperty("GROUPVEL");
+    G4MaterialPropertyVector* rindex   = mpt->GetProperty("RINDEX");
+    
+    // Photons outside the table range get the end values, as in Geant4
+    const G4double e0 = abs->Energy(0);
+    const G4double e1 = abs->Energy(abs->GetVectorLength() - 1);
+    ice_e0     = e0;
+    ice_inv_de = kIceBins / (e1 - e0);
+    ice_abs.resize(kIceBins + 2);
+    ice_inv_groupvel.resize(kIceBins + 2);
+    for (G4int i=0; i<=kIceBins; i++)
+    {
+        const G4double e = e0 + (e1 - e0) * i / kIceBins;
+        ice_abs[i] = abs->Value(e);
+        ice_inv_groupvel[i] = groupvel ? 1.0 / groupvel->Value(e)
+                                       : (rindex ? rindex->Value(e) : 1.0) / c_light;
+    }
+    // Repeated so the kernel can always read [j+1]
+    ice_abs[kIceBins + 1] = ice_abs[kIceBins];
+    ice_inv_groupvel[kIceBins + 1] = ice_inv_groupvel[kIceBins];
+    return true;
+}
+
+void TS01_PhotonBatch::Clear()
+{
+    x.clear();  y.clear();  z.clear();
+    ux.clear(); uy.clear(); uz.clear();
+    px.clear(); py.clear(); pz.clear();
+    energy.clear(); time.clear(); weight.clear();
+    track_id.clear(); parent_id.clear(); creator.clear();
+    alive.clear(); dist.clear(); path.clear(); inv_v.clear();
+}
+
+void TS01_PhotonBatch::Add(const G4Track* track)
+{
+    const G4ThreeVector& pos = track->GetPosition();
+    const G4ThreeVector& dir = track->GetMomentumDirection();
+    const G4ThreeVector& pol = track->GetPolarization();
+    x.push_back(pos.x());  y.push_back(pos.y());  z.push_back(pos.z());
+    ux.push_back(dir.x()); uy.push_back(dir.y()); uz.push_back(dir.z());
+    px.push_back(pol.x()); py.push_back(pol.y()); pz.push_back(pol.z());
+    energy.push_back(track->GetKineticEnergy());
+    time.push_back(track->GetGlobalTime());
+    weight.push_back(track->GetWeight());
+    track_id.push_back(track->GetTrackID());
+    parent_id.push_back(track->GetParentID());
+    creator.push_back(track->GetCreatorProcess());
+    alive.push_back(1);
+    dist.push_back(0.0);
+    path.push_back(0.0);
+    inv_v.push_back(0.0);
+}
+
+void TS01_PhotonBatch::Propagate(size_t begin, size_t end, const TS01_SensorBounds& bounds)
+{
+    const size_t n = end - begin;
+    const size_t i = begin;
+    
+    bounds.Distance(n, &x[i], &y[i], &z[i], &ux[i], &uy[i], &uz[i], &dist[i]);
+    FreePath(n, event_key, &track_id[i], &path[i]);
+    IceLookup(n, ice_e0, ice_inv_de, kIceBins, &ice_abs[0], &ice_inv_groupvel[0],
+              &energy[i], &path[i], &inv_v[i]);
+    Advance(n, &dist[i], &path[i], &inv_v[i], &ux[i], &uy[i], &uz[i],
+            &x[i], &y[i], &z[i], &time[i], &alive[i]);
+}
+
+void TS01_PhotonBatch::Fold(size_t begin, size_t end, const TS01_AcceptanceTable& table,
+                            G4double& unweighted, G4double& weighted) const
+{
+    unweighted = weighted = 0.0;
+    for (size_t i=begin; i<end; i++)
+    {
+        G4double p_u, p_w;
+        table.Lookup(G4ThreeVector(x[i], y[i], z[i]), G4ThreeVector(ux[i], uy[i], uz[i]),
+                     1240.0*eV / energy[i], p_u, p_w);
+        unweighted += weight[i] * p_u;
+        weighted   += weight[i] * p_w;
+    }
+}
+
+G4Track* TS01_PhotonBatch::MakeTrack(size_t i) const
+{
+    G4DynamicParticle* particle = new G4DynamicParticle(G4OpticalPhoton::OpticalPhotonDefinition(),
+                                                        G4ThreeVector(ux[i], uy[i], uz[i]), energy[i]);
+    particle->SetPolarization(G4ThreeVector(px[i], py[i], pz[i]));
+    G4Track* track = new G4Track(particle, time[i], G4ThreeVector(x[i], y[i], z[i]));
+    track->SetTrackID(track_id[i]);
+    track->SetParentID(parent_id[i]);
+    track->SetCreatorProcess(creator[i]);
+    track->SetWeight(weight[i]);
+    return track;
+}
@@ -0,0 +1,161 @@
+//
+//  TS01_PhotonPool.cc
+//  ts_01
+//
+
+#include <algorithm>
+
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
+#include "TS01_PhotonPool.hh"
+
+G4int TS01_PhotonPool::num_threads = -1;
+
+void TS01_PhotonPool::SetNumberOfThreads(G4int n)
+{
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    num_threads = n;
+}
+
+TS01_PhotonPool* TS01_PhotonPool::Instance()
+{
+    // Deliberately never deleted: pool threads outlive the run managers
+    static TS01_PhotonPool* instance = new TS01_PhotonPool(
+        num_threads >= 0 ? num_threads : DefaultThreads());
+    return instance;
+}
+
+G4int TS01_PhotonPool::DefaultThreads()
+{
+    // The cores left over by the Geant4 workers (-t), which also run
+    // tasks while they wait for their own
+    G4int workers = 1;
+#ifdef G4MULTITHREADED
+    const G4MTRunManager* master = G4MTRunManager::GetMasterRunManager();
+    if (master) workers = master->GetNumberOfThreads();
+#endif
+    return std::max(0, (G4int) std::thread::hardware_concurrency() - workers);
+}
+
+TS01_PhotonPool::TS01_PhotonPool(G4int n) :
+    queued(0),
+    stop(false)
+{
+    for (G4int i=0; i<=n; i++) queues.push_back(new Queue);
+    for (G4int i=0; i<n; i++) threads.push_back(std::thread(&TS01_PhotonPool::Work, this, (size_t) i));
+    G4cout << "TS01_PhotonPool: " << n << " threads" << G4endl;
+}
+
+TS01_PhotonPool::~TS01_PhotonPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(wake_lock);
+        stop = true;
+    }
+    wake.notify_all();
+    for (size_t i=0; i<threads.size(); i++) threads[i].join();
+    for (size_t i=0; i<queues.size(); i++) delete queues[i];
+}
+
+void TS01_PhotonPool::Run(size_t n_tasks, const Task& task)
+{
+    if (n_tasks == 0) return;
+    
+    Job job;
+    job.task    = &task;
+    job.pending = n_tasks;
+    
+    // Contiguous blocks per queue keep neighbouring photons on one thread
+    const size_t n_queues = queues.size();
+    for (size_t q=0; q<n_queues; q++)
+    {
+        const size_t begin = n_tasks * q / n_queues;
+        const size_t end   = n_tasks * (q + 1) / n_queues;
+        if (begin == end) continue;
+        std::lock_guard<std::mutex> guard(queues[q]->lock);
+        for (size_t i=begin; i<end; i++)
+        {
+            Item item = { &job, i };
+            queues[q]->items.push_back(item);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> guard(wake_lock);
+        queued += n_tasks;
+    }
+    wake.notify_all();
+    done.notify_all();
+    
+    // Help until all tasks of this job have finished; tasks of other jobs
+    // picked up on the way are run too.  With nothing left to take, sleep
+    // until the job's last task is done or more tasks are queued.
+    const size_t self = n_queues - 1;
+    while (job.pending > 0)
+    {
+        Item item;
+        if (Take(self, item))
+        {
+            Execute(item);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(wake_lock);
+        done.wait(guard, [this, &job] { return job.pending == 0 || queued > 0; });
+    }
+}
+
+G4bool TS01_PhotonPool::Take(size_t self, Item& item)
+{
+    {
+        Queue* q = queues[self];
+        std::lock_guard<std::mutex> guard(q->lock);
+        if (!q->items.empty())
+        {
+            item = q->items.back();
+            q->items.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    for (size_t k=1; k<queues.size(); k++)
+    {
+        Queue* q = queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(q->lock);
+        if (q->items.empty()) continue;
+        item = q->items.front();
+        q->items.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void TS01_PhotonPool::Execute(const Item& item)
+{
+    (*item.job->task)(item.index);
+    
+    // The job may be gone as soon as pending is 0; taking the lock before
+    // notifying keeps its submitter from missing the wakeup
+    if (--item.job->pending == 0)
+    {
+        std::lock_guard<std::mutex> guard(wake_lock);
+        done.notify_all();
+    }
+}
+
+void TS01_PhotonPool::Work(size_t self)
+{
+    for (;;)
+    {
+        Item item;
+        if (Take(self, item))
+        {
+            Execute(item);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(wake_lock);
+        wake.wait(guard, [this] { return stop || queued > 0; });
+        if (stop) return;
+    }
+}
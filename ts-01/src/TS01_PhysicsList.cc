@@ -1,24 +1,238 @@
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
 
 #include "G4Scintillation.hh"
 #include "G4Cerenkov.hh"
 #include "G4OpAbsorption.hh"
 #include "G4OpMieHG.hh"
 #include "G4OpBoundaryProcess.hh"
+#include "G4ProcessManager.hh"
+#include "G4ParticleTable.hh"
 #include "G4OpticalPhoton.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4Gamma.hh"
 #include "G4PhysicsListHelper.hh"
 #include "G4OpticalPhysics.hh"
 #include "G4EmStandardPhysics.hh"
+#include "G4FastSimulationPhysics.hh"
+#include "G4Material.hh"
+#include "G4Threading.hh"
+#include "G4Version.hh"
+#include "TS01_OpticalCache.hh"
+#include "TS01_OpAbsorption.hh"
+#include "TS01_OpWLS.hh"
+#include "TS01_IceModel.hh"
+#include "TS01_OpLayeredIce.hh"
+#include "TS01_CascadeCherenkov.hh"
+#include "TS01_Cerenkov.hh"
 #include "TS01_PhysicsList.hh"
 
-TS01_PhysicsList::TS01_PhysicsList() : G4VModularPhysicsList()
+TS01_PhysicsList::TS01_PhysicsList() :
+    G4VModularPhysicsList(),
+    cache_retrieve(false),
+    cache_pending(false),
+    cascade(false)
 {
     SetVerboseLevel(1);
     RegisterPhysics(new G4EmStandardPhysics());
     RegisterPhysics(new G4OpticalPhysics());
 }
 
+void TS01_PhysicsList::EnableFastSimulation()
+{
+    G4FastSimulationPhysics* fast = new G4FastSimulationPhysics();
+    fast->ActivateFastSimulation("opticalphoton");
+    RegisterPhysics(fast);
+}
+
+void TS01_PhysicsList::ConstructProcess()
+{
+    G4VModularPhysicsList::ConstructProcess();
+    
+    // Called on every thread; the processes read the master's shared tables
+    const G4bool cached  = TS01_OpticalCache::Instance()->IsEnabled();
+    const G4bool layered = TS01_IceModel::Instance()->IsLoaded();
+    if (cached || layered) ReplaceOpticalProcess("OpAbsorption", new TS01_OpAbsorption);
+    if (cached) ReplaceOpticalProcess("OpWLS", new TS01_OpWLS);
+    if (layered)
+        G4OpticalPhoton::OpticalPhotonDefinition()->GetProcessManager()->AddDiscreteProcess(
+            new TS01_OpLayeredIce);
+    
+    // Folds Cherenkov light in place of G4Cerenkov, but only while a fast
+    // acceptance table is loaded
+    AddCerenkovFold();
+    
+    // Parametrised cascades (--cascade), idle until /ts01/cascade/enable
+    if (cascade)
+    {
+        TS01_CascadeCherenkov* process = new TS01_CascadeCherenkov;
+        G4ParticleDefinition* showering[] = { G4Electron::Definition(), G4Positron::Definition(),
+                                              G4Gamma::Definition() };
+        for (int i=0; i<3; i++) showering[i]->GetProcessManager()->AddDiscreteProcess(process);
+    }
+}
+
+void TS01_PhysicsList::ReplaceOpticalProcess(const G4String& name, G4VProcess* process)
+{
+    G4ProcessManager* pm = G4OpticalPhoton::OpticalPhotonDefinition()->GetProcessManager();
+    G4VProcess* original = pm->GetProcess(name);
+    if (original == NULL)
+    {
+        G4ExceptionDescription msg;
+        msg << "No " << name << " process for optical photons, " << process->GetProcessName()
+            << " not registered";
+        G4Exception("TS01_PhysicsList::ReplaceOpticalProcess", "TS01_Phys003", JustWarning, msg);
+        delete process;
+        return;
+    }
+    // Processes cannot be inactivated before initialisation is over, so
+    // the original is taken off the optical photon instead.  It is not
+    // deleted: G4OpticalPhysics keeps its own pointer to it for the
+    // /process/optical/ commands.
+    pm->RemoveProcess(original);
+    pm->AddDiscreteProcess(process);
+}
+
+void TS01_PhysicsList::AddCerenkovFold()
+{
+    // G4OpticalPhysics shares one process between all charged particles
+    G4Cerenkov*    original = NULL;
+    TS01_Cerenkov* process  = NULL;
+    G4ParticleTable::G4PTblDicIterator* it = G4ParticleTable::GetParticleTable()->GetIterator();
+    it->reset();
+    while ((*it)())
+    {
+        G4ProcessManager* pm = it->value()->GetProcessManager();
+        G4Cerenkov* cerenkov = pm ? dynamic_cast<G4Cerenkov*>(pm->GetProcess("Cerenkov")) : NULL;
+        if (cerenkov == NULL) continue;
+        if (process == NULL)
+        {
+            original = cerenkov;
+            process  = new TS01_Cerenkov(cerenkov);
+        }
+        else if (cerenkov != original)
+        {
+            G4ExceptionDescription msg;
+            msg << "Cerenkov process of " << it->value()->GetParticleName()
+                << " is not shared, not folded";
+            G4Exception("TS01_PhysicsList::AddCerenkovFold", "TS01_Phys004", JustWarning, msg);
+            continue;
+        }
+        process->AddTo(pm);
+    }
+}
+
 void TS01_PhysicsList::SetCuts()
 {
     G4VModularPhysicsList::SetCuts();
+    
+    // Geometry (and so the material table) is built before physics, and
+    // only the master thread builds the shared tables
+    if (cache_dir == "" || !G4Threading::IsMasterThread()) return;
+    
+    const G4String desc = CacheDescription();
+    
+    // FNV-1a; any change to materials, cuts, constructors or Geant4
+    // version gives a new entry, so stale tables are never picked up
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i=0; i<desc.size(); i++)
+    {
+        h ^= (unsigned char) desc[i];
+        h *= 1099511628211ULL;
+    }
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long) h);
+    cache_entry = cache_dir + "/" + key;
+    
+    std::ifstream marker((cache_entry + "/complete").c_str());
+    std::string stored_key;
+    if (marker >> stored_key && stored_key == key)
+    {
+        G4cout << "TS01_PhysicsList: retrieving physics tables from " << cache_entry << G4endl;
+        SetPhysicsTableRetrieved(cache_entry);
+        cache_retrieve = true;
+        cache_pending  = false;
+    }
+    else
+    {
+        G4cout << "TS01_PhysicsList: no physics cache entry " << cache_entry
+               << ", tables will be stored after the first build" << G4endl;
+        cache_retrieve = false;
+        cache_pending  = true;
+    }
+}
+
+void TS01_PhysicsList::StorePhysicsCache()
+{
+    // A failed retrieve is reset by Geant4, rebuilt and then re-stored
+    if (cache_retrieve && !IsPhysicsTableRetrieved())
+    {
+        cache_retrieve = false;
+        cache_pending  = true;
+    }
+    if (!cache_pending) return;
+    cache_pending = false;
+    
+    const G4String dirs[] = { cache_dir, cache_entry };
+    for (int i=0; i<2; i++)
+    {
+        if (mkdir(dirs[i].c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            G4ExceptionDescription msg;
+            msg << "Cannot create physics cache directory " << dirs[i];
+            G4Exception("TS01_PhysicsList::StorePhysicsCache", "TS01_Phys001", JustWarning, msg);
+            return;
+        }
+    }
+    
+    // Remove the marker first so an interrupted store is never trusted
+    remove((cache_entry + "/complete").c_str());
+    
+    if (!StorePhysicsTable(cache_entry))
+    {
+        G4ExceptionDescription msg;
+        msg << "Failed to store physics tables in " << cache_entry;
+        G4Exception("TS01_PhysicsList::StorePhysicsCache", "TS01_Phys002", JustWarning, msg);
+        return;
+    }
+    
+    std::ofstream((cache_entry + "/key.txt").c_str()) << CacheDescription();
+    std::ofstream((cache_entry + "/complete").c_str())
+        << cache_entry.substr(cache_entry.rfind('/') + 1) << "\n";
+    G4cout << "TS01_PhysicsList: stored physics tables in " << cache_entry << G4endl;
 }
 
+G4String TS01_PhysicsList::CacheDescription() const
+{
+    std::ostringstream os;
+    os << std::setprecision(17);
+    
+    os << "geant4 " << G4VERSION_NUMBER << "\n";
+    for (G4int i=0; GetPhysics(i) != NULL; i++)
+        os << "physics " << GetPhysics(i)->GetPhysicsName() << "\n";
+    
+    os << "cut " << GetDefaultCutValue();
+    const char* particles[] = { "gamma", "e-", "e+", "proton" };
+    for (int i=0; i<4; i++) os << " " << GetCutValue(particles[i]);
+    os << "\n";
+    
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    for (size_t i=0; i<materials->size(); i++)
+    {
+        const G4Material* mat = (*materials)[i];
+        os << "material " << mat->GetName() << " " << mat->GetDensity() << " "
+           << mat->GetState() << " " << mat->GetTemperature() << " " << mat->GetPressure();
+        const G4double* fractions = mat->GetFractionVector();
+        for (size_t j=0; j<mat->GetNumberOfElements(); j++)
+            os << " " << mat->GetElement(j)->GetZ() << ":" << mat->GetElement(j)->GetN()
+               << ":" << fractions[j];
+        os << "\n";
+    }
+    return os.str();
+}
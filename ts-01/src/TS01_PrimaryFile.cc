@@ -0,0 +1,217 @@
+//
+//  TS01_PrimaryFile.cc
+//  ts_01
+//
+
+#include <string.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+#include "TS01_PrimaryFile.hh"
+
+namespace
+{
+    G4Mutex output_mutex = G4MUTEX_INITIALIZER;
+}
+
+FILE*    TS01_PrimaryFile::output = NULL;
+G4String TS01_PrimaryFile::output_name;
+
+TS01_PrimaryFile::TS01_PrimaryFile() :
+    map(NULL),
+    map_size(0),
+    records(NULL)
+{
+    
+}
+
+TS01_PrimaryFile::~TS01_PrimaryFile()
+{
+    Close();
+}
+
+G4bool TS01_PrimaryFile::Open(const G4String& file_name)
+{
+    Close();
+    
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0) close(fd);
+        G4ExceptionDescription msg;
+        msg << "Cannot open primary file " << file_name;
+        G4Exception("TS01_PrimaryFile::Open", "TS01_Primary001", JustWarning, msg);
+        return false;
+    }
+    map_size = st.st_size;
+    map = map_size > 0 ? mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    
+    const TS01_PrimaryFileHeader* header = static_cast<const TS01_PrimaryFileHeader*>(map);
+    if (map == MAP_FAILED || map_size < sizeof(TS01_PrimaryFileHeader) ||
+        memcmp(header->magic, "TS01PRI", 8) != 0 || header->version != version ||
+        header->record_size != sizeof(TS01_PrimaryRecord))
+    {
+        if (map != MAP_FAILED) munmap(map, map_size);
+        map = NULL;
+        G4ExceptionDescription msg;
+        msg << file_name << " is not a version " << version << " primary file";
+        G4Exception("TS01_PrimaryFile::Open", "TS01_Primary002", JustWarning, msg);
+        return false;
+    }
+    madvise(map, map_size, MADV_SEQUENTIAL);
+    
+    records = reinterpret_cast<const TS01_PrimaryRecord*>(header + 1);
+    const size_t n = (map_size - sizeof(TS01_PrimaryFileHeader)) / sizeof(TS01_PrimaryRecord);
+    for (size_t i=0; i<n; i++)
+    {
+        const TS01_PrimaryRecord& r = records[i];
+        if (i == 0 || r.run != records[i-1].run || r.event != records[i-1].event)
+        {
+            Block b = { r.run, r.event, i, i };
+            blocks.push_back(b);
+        }
+        blocks.back().end = i + 1;
+    }
+    if (blocks.empty())
+    {
+        G4ExceptionDescription msg;
+        msg << "Primary file " << file_name << " holds no events";
+        G4Exception("TS01_PrimaryFile::Open", "TS01_Primary003", JustWarning, msg);
+        Close();
+        return false;
+    }
+    std::stable_sort(blocks.begin(), blocks.end());
+    name = file_name;
+    
+    G4cout << "TS01_PrimaryFile: " << file_name << ", " << GetNumberOfEvents() << " events, "
+           << n << " primaries" << G4endl;
+    return true;
+}
+
+void TS01_PrimaryFile::Close()
+{
+    if (map) munmap(map, map_size);
+    map = NULL;
+    map_size = 0;
+    records = NULL;
+    blocks.clear();
+}
+
+void TS01_PrimaryFile::Fill(G4int i, G4Event* evt) const
+{
+    const G4int n_events = GetNumberOfEvents();
+    const G4int k = ((i % n_events) + n_events) % n_events;
+    G4ParticleTable* table = G4ParticleTable::GetParticleTable();
+    
+    for (size_t j=blocks[k].begin; j<blocks[k].end; j++)
+    {
+        const TS01_PrimaryRecord& r = records[j];
+        G4ParticleDefinition* def = table->FindParticle(r.pdg);
+        if (def == NULL)
+        {
+            G4ExceptionDescription msg;
+            msg << "Unknown PDG code " << r.pdg << " in " << name;
+            G4Exception("TS01_PrimaryFile::Fill", "TS01_Primary004", JustWarning, msg);
+            continue;
+        }
+        G4PrimaryParticle* particle = new G4PrimaryParticle(def);
+        particle->SetKineticEnergy(r.energy * MeV);
+        particle->SetMomentumDirection(G4ThreeVector(r.dir[0], r.dir[1], r.dir[2]).unit());
+        particle->SetPolarization(r.pol[0], r.pol[1], r.pol[2]);
+        particle->SetWeight(r.weight);
+        
+        G4PrimaryVertex* vertex = new G4PrimaryVertex(
+            G4ThreeVector(r.pos[0]*mm, r.pos[1]*mm, r.pos[2]*mm), r.time * ns);
+        vertex->SetPrimary(particle);
+        evt->AddPrimaryVertex(vertex);
+    }
+}
+
+G4bool TS01_PrimaryFile::OpenOutput(const G4String& file_name)
+{
+    G4AutoLock lock(&output_mutex);
+    if (output && output_name == file_name) return true;
+    if (output) fclose(output);
+    output = fopen(file_name.c_str(), "wb");
+    output_name = file_name;
+    if (output == NULL)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot write primary file " << file_name;
+        G4Exception("TS01_PrimaryFile::OpenOutput", "TS01_Primary005", JustWarning, msg);
+        return false;
+    }
+    
+    TS01_PrimaryFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TS01PRI", 8);
+    header.version     = version;
+    header.record_size = sizeof(TS01_PrimaryRecord);
+    fwrite(&header, sizeof(header), 1, output);
+    return true;
+}
+
+void TS01_PrimaryFile::CloseOutput()
+{
+    G4AutoLock lock(&output_mutex);
+    if (output) fclose(output);
+    output = NULL;
+    output_name = "";
+}
+
+void TS01_PrimaryFile::FlushOutput()
+{
+    G4AutoLock lock(&output_mutex);
+    if (output) fflush(output);
+}
+
+void TS01_PrimaryFile::Write(const G4Event* evt, G4int run_id)
+{
+    // Another thread may close the output at any time, so look at it only
+    // under the lock; the records are built outside it
+    G4AutoLock lock(&output_mutex);
+    if (output == NULL) return;
+    lock.unlock();
+    
+    std::vector<TS01_PrimaryRecord> event_records;
+    for (G4int v=0; v<evt->GetNumberOfPrimaryVertex(); v++)
+    {
+        const G4PrimaryVertex* vertex = evt->GetPrimaryVertex(v);
+        const G4ThreeVector x = vertex->GetPosition();
+        for (G4int p=0; p<vertex->GetNumberOfParticle(); p++)
+        {
+            const G4PrimaryParticle* particle = vertex->GetPrimary(p);
+            const G4ThreeVector u   = particle->GetMomentumDirection();
+            const G4ThreeVector pol = particle->GetPolarization();
+            
+            TS01_PrimaryRecord r;
+            r.run    = run_id;
+            r.event  = evt->GetEventID();
+            r.pdg    = particle->GetParticleDefinition()->GetPDGEncoding();
+            r.pos[0] = x.x() / mm;  r.pos[1] = x.y() / mm;  r.pos[2] = x.z() / mm;
+            r.dir[0] = u.x();       r.dir[1] = u.y();       r.dir[2] = u.z();
+            r.pol[0] = pol.x();     r.pol[1] = pol.y();     r.pol[2] = pol.z();
+            r.energy = particle->GetKineticEnergy() / MeV;
+            r.time   = vertex->GetT0() / ns;
+            r.weight = particle->GetWeight() * vertex->GetWeight();
+            event_records.push_back(r);
+        }
+    }
+    if (event_records.empty()) return;
+    
+    lock.lock();
+    if (output)
+        fwrite(&event_records[0], sizeof(TS01_PrimaryRecord), event_records.size(), output);
+}
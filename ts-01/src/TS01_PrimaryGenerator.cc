@@ -1,22 +1,123 @@
 /*
  * Geant4 physics generator using GPS.  It should be configured through
- * the UI.
+ * the UI.  Primaries can also be replayed from, or recorded to, a
+ * TS01_PrimaryFile (/ts01/primary/).
  */
+#include "G4RunManager.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
 #include "TS01_PrimaryGenerator.hh"
+#include "TS01_RunAction.hh"
+#include "TS01_PrimaryMessenger.hh"
+#include "TS01_Shard.hh"
+#include "TS01_Checkpoint.hh"
 
-TS01_PrimaryGenerator::TS01_PrimaryGenerator()
+G4bool TS01_PrimaryGenerator::record_only = false;
+
+TS01_PrimaryGenerator::TS01_PrimaryGenerator() :
+    verbose(0)
 {
 	src = new G4GeneralParticleSource;
+    messenger = new TS01_PrimaryMessenger(this);
 }
 
 TS01_PrimaryGenerator::~TS01_PrimaryGenerator()
 {
+    delete messenger;
 	delete src;
 }
 
+void TS01_PrimaryGenerator::SetReplayFile(const G4String& file)
+{
+    if (file == "")
+        replay.Close();
+    else
+        replay.Open(file);
+}
+
+void TS01_PrimaryGenerator::SetRecordFile(const G4String& file, G4bool only)
+{
+    G4bool recording = false;
+    if (file == "")
+        TS01_PrimaryFile::CloseOutput();
+    else
+        recording = TS01_PrimaryFile::OpenOutput(file);
+    record_only = recording && only;
+}
+
 void TS01_PrimaryGenerator::GeneratePrimaries(G4Event* evt)
 {
-	src->GeneratePrimaryVertex(evt);
-    evt->Print();
-     // G4cout << "Generated something" << G4endl;
+    // Past the end of this job's event range, or already done in a
+    // resumed checkpoint: nothing to generate
+    G4RunManager* rm = G4RunManager::GetRunManager();
+    if (!TS01_Shard::Instance()->BeginEvent(evt, rm->GetCurrentRun()->GetRunID())) return;
+    if (TS01_Checkpoint::Instance()->IsDone(evt->GetEventID()))
+    {
+        evt->SetEventAborted();
+        return;
+    }
+    
+    const TS01_RunAction* run_action = static_cast<const TS01_RunAction*>(rm->GetUserRunAction());
+    if (run_action->GetAcceptanceBuild())
+    {
+        InjectPhotons(evt, *run_action->GetAcceptanceBuild());
+        return;
+    }
+    
+    if (replay.IsOpen())
+        replay.Fill(evt->GetEventID(), evt);
+    else
+        src->GeneratePrimaryVertex(evt);
+    
+    TS01_PrimaryFile::Write(evt, rm->GetCurrentRun()->GetRunID());
+    
+    if (verbose > 1)
+        evt->Print();
+    else if (verbose == 1)
+        PrintSummary(evt);
+}
+
+void TS01_PrimaryGenerator::PrintSummary(const G4Event* evt) const
+{
+    G4int n = 0;
+    for (G4int v=0; v<evt->GetNumberOfPrimaryVertex(); v++)
+        n += evt->GetPrimaryVertex(v)->GetNumberOfParticle();
+    
+    G4cout << "Event " << evt->GetEventID() << ": " << n << " primaries";
+    if (n > 0)
+    {
+        const G4PrimaryVertex*   vertex   = evt->GetPrimaryVertex(0);
+        const G4PrimaryParticle* particle = vertex->GetPrimary(0);
+        G4cout << ", first " << particle->GetParticleDefinition()->GetParticleName() << " "
+               << particle->GetKineticEnergy() / MeV << " MeV at " << vertex->GetPosition() / mm
+               << " mm along " << particle->GetMomentumDirection();
+    }
+    G4cout << G4endl;
+}
+
+void TS01_PrimaryGenerator::InjectPhotons(G4Event* evt, const TS01_AcceptanceTable& table)
+{
+    const G4int bin = table.InjectionBin(evt->GetEventID());
+    for (G4int i=0; i<table.GetPhotonsPerEvent(); i++)
+    {
+        G4ThreeVector x, u;
+        G4double wl;
+        table.SamplePhoton(bin, x, u, wl);
+        
+        G4ThreeVector pol = u.orthogonal().unit();
+        pol.rotate(twopi*G4UniformRand(), u);
+        
+        G4PrimaryParticle* photon = new G4PrimaryParticle(G4OpticalPhoton::Definition());
+        photon->SetKineticEnergy(1240.0*eV / wl);
+        photon->SetMomentumDirection(u);
+        photon->SetPolarization(pol.x(), pol.y(), pol.z());
+        
+        G4PrimaryVertex* vertex = new G4PrimaryVertex(x, 0.0);
+        vertex->SetPrimary(photon);
+        evt->AddPrimaryVertex(vertex);
+    }
 }
@@ -0,0 +1,66 @@
+//
+//  TS01_PrimaryMessenger.cc
+//  ts_01
+//
+
+#include <sstream>
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "TS01_PrimaryGenerator.hh"
+#include "TS01_PrimaryMessenger.hh"
+
+TS01_PrimaryMessenger::TS01_PrimaryMessenger(TS01_PrimaryGenerator* gen) :
+    generator(gen)
+{
+    primary_dir = new G4UIdirectory("/ts01/primary/");
+    primary_dir->SetGuidance("Primary replay and recording.");
+    
+    replay_cmd = new G4UIcmdWithAString("/ts01/primary/replay", this);
+    replay_cmd->SetGuidance("Take primaries from a file written with /ts01/primary/record instead");
+    replay_cmd->SetGuidance("of GPS.  Event i replays stored event i modulo the number stored.");
+    replay_cmd->SetGuidance("\"none\" goes back to GPS.");
+    replay_cmd->SetParameterName("file", false);
+    replay_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    record_cmd = new G4UIcommand("/ts01/primary/record", this);
+    record_cmd->SetGuidance("Write every event's primaries to <file> (\"none\" closes it).");
+    record_cmd->SetGuidance("With <only> true nothing is tracked, so a macro's GPS");
+    record_cmd->SetGuidance("configuration can be turned into a file quickly.");
+    record_cmd->SetParameter(new G4UIparameter("file", 's', false));
+    G4UIparameter* only = new G4UIparameter("only", 'b', true);
+    only->SetDefaultValue("false");
+    record_cmd->SetParameter(only);
+    record_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    verbose_cmd = new G4UIcmdWithAnInteger("/ts01/primary/verbose", this);
+    verbose_cmd->SetGuidance("0: quiet, 1: one line per event, 2: full G4Event::Print().");
+    verbose_cmd->SetParameterName("level", false);
+    verbose_cmd->SetRange("level >= 0");
+}
+
+TS01_PrimaryMessenger::~TS01_PrimaryMessenger()
+{
+    delete verbose_cmd;
+    delete record_cmd;
+    delete replay_cmd;
+    delete primary_dir;
+}
+
+void TS01_PrimaryMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    if (cmd == replay_cmd)
+        generator->SetReplayFile(value == "none" ? G4String("") : value);
+    else if (cmd == record_cmd)
+    {
+        G4String file, only = "false";
+        std::istringstream is(value);
+        is >> file >> only;
+        generator->SetRecordFile(file == "none" ? G4String("") : file,
+                                 G4UIcommand::ConvertToBool(only));
+    }
+    else if (cmd == verbose_cmd)
+        generator->SetVerbose(G4UIcmdWithAnInteger::GetNewIntValue(value));
+}
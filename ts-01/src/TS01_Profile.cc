@@ -0,0 +1,111 @@
+//
+//  TS01_Profile.cc
+//  ts_01
+//
+
+#include <algorithm>
+#include <iomanip>
+
+#include "TS01_Profile.hh"
+
+namespace
+{
+    struct ByCost
+    {
+        const std::vector<TS01_Profile::Entry>* v;
+        G4bool timed;
+        bool operator()(size_t a, size_t b) const
+        {
+            return timed ? (*v)[a].time > (*v)[b].time : (*v)[a].steps > (*v)[b].steps;
+        }
+    };
+}
+
+TS01_Profile::TS01_Profile()
+{
+    for (G4int i=0; i<kNumTables; i++) last[i] = 0;
+}
+
+TS01_Profile::Entry* TS01_Profile::Add(G4int table, const void* key, const G4String& name)
+{
+    Entry e;
+    e.key    = key;
+    e.name   = name;
+    e.steps  = 0;
+    e.tracks = 0;
+    e.time   = 0.0;
+    tables[table].push_back(e);
+    last[table] = tables[table].size() - 1;
+    return &tables[table].back();
+}
+
+void TS01_Profile::Merge(const TS01_Profile& other)
+{
+    for (G4int t=0; t<kNumTables; t++)
+    {
+        std::vector<Entry>& v = tables[t];
+        for (size_t i=0; i<other.tables[t].size(); i++)
+        {
+            const Entry& e = other.tables[t][i];
+            size_t j = 0;
+            while (j < v.size() && v[j].name != e.name) j++;
+            if (j == v.size()) Add(t, NULL, e.name);
+            v[j].steps  += e.steps;
+            v[j].tracks += e.tracks;
+            v[j].time   += e.time;
+        }
+    }
+}
+
+G4long TS01_Profile::GetSteps(G4int table) const
+{
+    G4long steps = 0;
+    for (size_t i=0; i<tables[table].size(); i++) steps += tables[table][i].steps;
+    return steps;
+}
+
+G4long TS01_Profile::GetTracks(G4int table, const G4String& name) const
+{
+    G4long tracks = 0;
+    for (size_t i=0; i<tables[table].size(); i++)
+        if (tables[table][i].name == name) tracks += tables[table][i].tracks;
+    return tracks;
+}
+
+void TS01_Profile::Print(G4int top) const
+{
+    const char* titles[kNumTables] = { "volume", "process", "particle" };
+    
+    for (G4int t=0; t<kNumTables; t++)
+    {
+        const std::vector<Entry>& v = tables[t];
+        G4long   steps = 0, tracks = 0;
+        G4double time = 0.0;
+        for (size_t i=0; i<v.size(); i++)
+        {
+            steps  += v[i].steps;
+            tracks += v[i].tracks;
+            time   += v[i].time;
+        }
+        
+        std::vector<size_t> order(v.size());
+        for (size_t i=0; i<v.size(); i++) order[i] = i;
+        ByCost by_cost = { &v, time > 0.0 };
+        std::sort(order.begin(), order.end(), by_cost);
+        
+        G4cout << "Profile by " << titles[t] << ": " << steps << " steps, " << tracks
+               << " tracks, ~" << time << " s" << G4endl;
+        G4cout << std::setw(24) << titles[t] << std::setw(14) << "steps" << std::setw(8) << "%"
+               << std::setw(12) << "tracks" << std::setw(12) << "time [s]" << std::setw(8) << "%"
+               << G4endl;
+        for (size_t k=0; k<order.size() && (G4int) k<top; k++)
+        {
+            const Entry& e = v[order[k]];
+            G4cout << std::setw(24) << e.name << std::setw(14) << e.steps
+                   << std::setw(8) << std::setprecision(3) << (steps ? 100.0 * e.steps / steps : 0.0)
+                   << std::setw(12) << e.tracks << std::setw(12) << e.time
+                   << std::setw(8) << (time > 0.0 ? 100.0 * e.time / time : 0.0)
+                   << std::setprecision(6) << G4endl;
+        }
+    }
+}
@@ -0,0 +1,98 @@
+//
+//  TS01_Profiler.cc
+//  ts_01
+//
+
+#include <chrono>
+
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "TS01_Run.hh"
+#include "TS01_Profile.hh"
+#include "TS01_Profiler.hh"
+
+namespace
+{
+    inline G4double Now()
+    {
+        return std::chrono::duration<G4double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    inline TS01_Profile::Entry* Volume(TS01_Profile* p, const G4VPhysicalVolume* pv)
+    {
+        const G4LogicalVolume* lv = pv ? pv->GetLogicalVolume() : NULL;
+        TS01_Profile::Entry* e = p->Find(TS01_Profile::kVolume, lv);
+        return e ? e : p->Add(TS01_Profile::kVolume, lv, lv ? lv->GetName() : G4String("none"));
+    }
+    
+    inline TS01_Profile::Entry* Process(TS01_Profile* p, const G4VProcess* proc, const char* none)
+    {
+        TS01_Profile::Entry* e = p->Find(TS01_Profile::kProcess, proc);
+        return e ? e : p->Add(TS01_Profile::kProcess, proc, proc ? proc->GetProcessName() : G4String(none));
+    }
+    
+    inline TS01_Profile::Entry* Particle(TS01_Profile* p, const G4ParticleDefinition* def)
+    {
+        TS01_Profile::Entry* e = p->Find(TS01_Profile::kParticle, def);
+        return e ? e : p->Add(TS01_Profile::kParticle, def, def->GetParticleName());
+    }
+}
+
+TS01_Profiler::TS01_Profiler() :
+    enabled(false),
+    sampling_period(64),
+    countdown(64),
+    armed(false),
+    t0(0.0),
+    profile(NULL)
+{
+    
+}
+
+void TS01_Profiler::BeginTrack(const G4Track* track)
+{
+    if (!enabled) return;
+    
+    // The run changes between runs, tracks are far fewer than steps
+    profile = &static_cast<TS01_Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun())->GetProfile();
+    
+    Volume(profile, track->GetVolume())->tracks++;
+    Process(profile, track->GetCreatorProcess(), "primary")->tracks++;
+    Particle(profile, track->GetDefinition())->tracks++;
+    
+    // Do not charge stacking and track setup to the next step
+    if (armed) t0 = Now();
+}
+
+void TS01_Profiler::UserSteppingAction(const G4Step* step)
+{
+    if (!enabled || !profile) return;
+    
+    TS01_Profile::Entry* v = Volume(profile, step->GetPreStepPoint()->GetPhysicalVolume());
+    TS01_Profile::Entry* p = Process(profile, step->GetPostStepPoint()->GetProcessDefinedStep(), "none");
+    TS01_Profile::Entry* d = Particle(profile, step->GetTrack()->GetDefinition());
+    v->steps++;
+    p->steps++;
+    d->steps++;
+    
+    if (armed)
+    {
+        const G4double dt = (Now() - t0) * sampling_period;
+        v->time += dt;
+        p->time += dt;
+        d->time += dt;
+        armed = false;
+    }
+    if (sampling_period > 0 && --countdown <= 0)
+    {
+        countdown = sampling_period;
+        armed = true;
+        t0 = Now();
+    }
+}
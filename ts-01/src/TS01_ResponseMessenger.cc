@@ -0,0 +1,72 @@
+//
+//  TS01_ResponseMessenger.cc
+//  ts_01
+//
+
+#include <sstream>
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_SpectralResponse.hh"
+#include "TS01_ResponseMessenger.hh"
+
+TS01_ResponseMessenger::TS01_ResponseMessenger(TS01_DetectorConstruction* det) :
+    detector(det)
+{
+    response_dir = new G4UIdirectory("/ts01/response/", false);
+    response_dir->SetGuidance("Sensor spectral response (QE x collection efficiency x gain).");
+
+    load_cmd = new G4UIcommand("/ts01/response/load", this);
+    load_cmd->SetGuidance("Load response <name> from <file>: \"<wl [nm]> <qe> [<ce>]\" lines,");
+    load_cmd->SetGuidance("efficiencies as fractions, linearly interpolated.");
+    load_cmd->SetParameter(new G4UIparameter("name", 's', false));
+    load_cmd->SetParameter(new G4UIparameter("file", 's', false));
+    load_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    load_cmd->SetToBeBroadcasted(false);
+
+    gains_cmd = new G4UIcommand("/ts01/response/gains", this);
+    gains_cmd->SetGuidance("Load per-channel gains of response <name>: \"<channel> <gain>\" lines.");
+    gains_cmd->SetParameter(new G4UIparameter("name", 's', false));
+    gains_cmd->SetParameter(new G4UIparameter("file", 's', false));
+    gains_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    gains_cmd->SetToBeBroadcasted(false);
+
+    assign_cmd = new G4UIcommand("/ts01/response/assign", this);
+    assign_cmd->SetGuidance("Use response <name> for hits in sensitive logical volume <volume>");
+    assign_cmd->SetGuidance("(PhotoCathode_LV for fibers, PMTEnvelope for the DOM).");
+    assign_cmd->SetParameter(new G4UIparameter("volume", 's', false));
+    assign_cmd->SetParameter(new G4UIparameter("name", 's', false));
+    assign_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    assign_cmd->SetToBeBroadcasted(false);
+
+    list_cmd = new G4UIcmdWithoutParameter("/ts01/response/list", this);
+    list_cmd->SetGuidance("List responses and volume assignments.");
+    list_cmd->SetToBeBroadcasted(false);
+}
+
+TS01_ResponseMessenger::~TS01_ResponseMessenger()
+{
+    delete list_cmd;
+    delete assign_cmd;
+    delete gains_cmd;
+    delete load_cmd;
+    delete response_dir;
+}
+
+void TS01_ResponseMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    G4String a, b;
+    std::istringstream is(value);
+    is >> a >> b;
+
+    if (cmd == load_cmd)
+        detector->GetResponse(a, true)->Load(b);
+    else if (cmd == gains_cmd)
+        detector->GetResponse(a, true)->LoadGains(b);
+    else if (cmd == assign_cmd)
+        detector->AssignResponse(a, b);
+    else if (cmd == list_cmd)
+        detector->ListResponses();
+}
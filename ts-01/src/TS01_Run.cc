@@ -0,0 +1,171 @@
+//
+//  TS01_Run.cc
+//  ts_01
+//
+
+#include <istream>
+#include <ostream>
+
+#include "TS01_Run.hh"
+
+TS01_Run::TS01_Run(const TS01_Histogram* binning, const TS01_AcceptanceTable* acceptance_binning) :
+    n_events(0),
+    cascades(0),
+    acceptance(NULL)
+{
+    for (G4int i=0; i<kNumHistograms; i++)
+    {
+        histograms[i] = binning[i];
+        histograms[i].Reset();
+    }
+    for (G4int i=0; i<kNumCullCounters; i++) cull_counts[i] = 0;
+    for (G4int i=0; i<kNumThinCounters; i++) thin_counts[i] = 0;
+    for (G4int i=0; i<kNumLightCounters; i++) light[i] = TS01_Fixed();
+    for (G4int i=0; i<kNumWorkCounters; i++) work_counts[i] = 0;
+    
+    if (acceptance_binning)
+    {
+        acceptance = new TS01_AcceptanceTable(*acceptance_binning);
+        acceptance->Reset();
+    }
+}
+
+TS01_Run::~TS01_Run()
+{
+    delete acceptance;
+}
+
+void TS01_Run::AddEvent(G4int event_id, G4double unweighted, G4double weighted)
+{
+    n_events++;
+    sum_unweighted  += unweighted;
+    sum_weighted    += weighted;
+    sum2_unweighted += unweighted*unweighted;
+    sum2_weighted   += weighted*weighted;
+    
+    histograms[kHits].Fill(unweighted);
+    histograms[kWeightedHits].Fill(weighted);
+    
+    // In build mode each event is one injection into one table bin
+    if (acceptance)
+        acceptance->AddInjection(acceptance->InjectionBin(event_id), unweighted, weighted);
+}
+
+void TS01_Run::AddChannel(G4int channel, G4double photons, G4double weighted)
+{
+    if (channel >= (G4int) channel_events.size())
+    {
+        channel_events.resize(channel + 1, 0);
+        channel_photons.resize(channel + 1);
+        channel_weighted.resize(channel + 1);
+    }
+    channel_events[channel]++;
+    channel_photons[channel]  += photons;
+    channel_weighted[channel] += weighted;
+}
+
+void TS01_Run::Merge(const G4Run *run)
+{
+    const TS01_Run *local = static_cast<const TS01_Run*>(run);
+
+    n_events        += local->n_events;
+    sum_unweighted  += local->sum_unweighted;
+    sum_weighted    += local->sum_weighted;
+    sum2_unweighted += local->sum2_unweighted;
+    sum2_weighted   += local->sum2_weighted;
+    
+    for (G4int i=0; i<kNumHistograms; i++)
+        histograms[i].Merge(local->histograms[i]);
+    for (G4int i=0; i<kNumCullCounters; i++)
+        cull_counts[i] += local->cull_counts[i];
+    for (G4int i=0; i<kNumThinCounters; i++)
+        thin_counts[i] += local->thin_counts[i];
+    cascades += local->cascades;
+    for (G4int i=0; i<kNumLightCounters; i++)
+        light[i] += local->light[i];
+    for (G4int i=0; i<kNumWorkCounters; i++)
+        work_counts[i] += local->work_counts[i];
+    sum_hit_weight  += local->sum_hit_weight;
+    sum_hit_weight2 += local->sum_hit_weight2;
+    if (local->GetNumberOfChannels() > GetNumberOfChannels())
+    {
+        channel_events.resize(local->GetNumberOfChannels(), 0);
+        channel_photons.resize(local->GetNumberOfChannels());
+        channel_weighted.resize(local->GetNumberOfChannels());
+    }
+    for (G4int c=0; c<local->GetNumberOfChannels(); c++)
+    {
+        channel_events[c]   += local->channel_events[c];
+        channel_photons[c]  += local->channel_photons[c];
+        channel_weighted[c] += local->channel_weighted[c];
+    }
+    if (acceptance && local->acceptance)
+        acceptance->Merge(*local->acceptance);
+    profile.Merge(local->profile);
+
+    G4Run::Merge(run);
+}
+
+void TS01_Run::WriteSummary(std::ostream& os) const
+{
+    // Enough digits for the histogram limits; fixed-point sums print exactly
+    const std::streamsize precision = os.precision(17);
+    
+    os << "summary " << kSummaryVersion << "\n"
+       << "events " << n_events << "\n"
+       << "hits " << sum_unweighted << " " << sum_weighted << " "
+       << sum2_unweighted << " " << sum2_weighted << "\n"
+       << "cull " << cull_counts[kCullSeen] << " " << cull_counts[kCullGeometry] << " "
+       << cull_counts[kCullPath] << " " << cull_counts[kCullDetected] << "\n"
+       << "thin " << thin_counts[kThinSeen] << " " << thin_counts[kThinKept] << " "
+       << sum_hit_weight << " " << sum_hit_weight2 << "\n"
+       << "light " << cascades;
+    for (G4int i=0; i<kNumLightCounters; i++) os << " " << light[i];
+    os << "\n";
+    for (G4int i=0; i<kNumHistograms; i++)
+        histograms[i].Write(os);
+    
+    // Light sharing across the ring: channel, events hit, photons, weighted
+    os << "channels " << GetNumberOfChannels() << "\n";
+    for (G4int c=0; c<GetNumberOfChannels(); c++)
+        os << c << " " << channel_events[c] << " " << channel_photons[c] << " "
+           << channel_weighted[c] << "\n";
+    
+    os.precision(precision);
+}
+
+G4bool TS01_Run::ReadSummary(std::istream& is)
+{
+    G4String tag;
+    G4int version;
+    
+    if (!(is >> tag >> version) || tag != "summary" || version != kSummaryVersion) return false;
+    if (!(is >> tag >> n_events) || tag != "events") return false;
+    if (!(is >> tag >> sum_unweighted >> sum_weighted >> sum2_unweighted >> sum2_weighted) ||
+        tag != "hits")
+        return false;
+    
+    if (!(is >> tag) || tag != "cull") return false;
+    for (G4int i=0; i<kNumCullCounters; i++) is >> cull_counts[i];
+    if (!(is >> tag >> thin_counts[kThinSeen] >> thin_counts[kThinKept]
+             >> sum_hit_weight >> sum_hit_weight2) || tag != "thin")
+        return false;
+    if (!(is >> tag >> cascades) || tag != "light") return false;
+    for (G4int i=0; i<kNumLightCounters; i++)
+        if (!(is >> light[i])) return false;
+    for (G4int i=0; i<kNumHistograms; i++)
+        if (!histograms[i].Read(is)) return false;
+    
+    G4int n;
+    if (!(is >> tag >> n) || tag != "channels" || n < 0) return false;
+    channel_events.assign(n, 0);
+    channel_photons.assign(n, TS01_Fixed());
+    channel_weighted.assign(n, TS01_Fixed());
+    for (G4int i=0; i<n; i++)
+    {
+        G4int c;
+        if (!(is >> c >> channel_events[i] >> channel_photons[i] >> channel_weighted[i]) || c != i)
+            return false;
+    }
+    return true;
+}
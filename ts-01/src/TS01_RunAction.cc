@@ -0,0 +1,309 @@
+//
+//  TS01_RunAction.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <fstream>
+
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
+#include "TS01_Bench.hh"
+#include "TS01_Telemetry.hh"
+#include "TS01_Checkpoint.hh"
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_HitWriter.hh"
+#include "TS01_PhysicsList.hh"
+#include "TS01_PrimaryFile.hh"
+#include "TS01_Profiler.hh"
+#include "TS01_Run.hh"
+#include "TS01_RunAction.hh"
+#include "TS01_RunMessenger.hh"
+
+TS01_RunAction::TS01_RunAction() :
+    G4UserRunAction(),
+    text_hits(false),
+    summary_written(false),
+    acceptance_mode(kAcceptanceOff),
+    profiler(NULL),
+    profile_sampling(64),
+    profile_top(10),
+    full_em_valid(false),
+    full_em_light(0.0),
+    full_em_hits(0.0),
+    full_em_hits_err(0.0)
+{
+    binning[TS01_Run::kHits]         = TS01_Histogram("hits", 100, 0.0, 100.0);
+    binning[TS01_Run::kWeightedHits] = TS01_Histogram("weighted_hits", 100, 0.0, 25.0);
+    binning[TS01_Run::kTime]         = TS01_Histogram("time_ns", 200, 0.0, 200.0);
+    binning[TS01_Run::kWavelength]   = TS01_Histogram("wavelength_nm", 80, 300.0, 700.0);
+    
+    messenger = new TS01_RunMessenger(this);
+}
+
+TS01_RunAction::~TS01_RunAction()
+{
+    delete messenger;
+}
+
+G4Run* TS01_RunAction::GenerateRun()
+{
+    return new TS01_Run(binning, GetAcceptanceBuild());
+}
+
+void TS01_RunAction::BuildAcceptance(const G4String& file, G4int photons)
+{
+    const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if (!acceptance.CheckSymmetry(det)) return;
+    
+    acceptance_mode = kAcceptanceBuild;
+    acceptance_file = file;
+    acceptance.SetPhotonsPerEvent(photons);
+    G4cout << "TS01_RunAction: building acceptance table " << file << ", "
+           << acceptance.GetNumberOfBins() << " bins, " << photons << " photons/event" << G4endl;
+}
+
+void TS01_RunAction::LoadAcceptance(const G4String& file)
+{
+    acceptance_mode = kAcceptanceOff;
+    
+    // Only threads that process events look photons up
+    if (G4RunManager::GetRunManager()->GetRunManagerType() == G4RunManager::masterRM)
+    {
+        acceptance_mode = kAcceptanceFast;
+        return;
+    }
+    
+    const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if (acceptance.Read(file, det))
+    {
+        acceptance_mode = kAcceptanceFast;
+        acceptance_file = file;
+    }
+}
+
+void TS01_RunAction::SetProfiling(G4bool on)
+{
+    // Only threads that process events step; the master just reports
+    G4RunManager* rm = G4RunManager::GetRunManager();
+    if (rm->GetRunManagerType() == G4RunManager::masterRM) return;
+    
+    if (!profiler)
+    {
+        if (!on) return;
+        profiler = new TS01_Profiler;
+        profiler->SetSamplingPeriod(profile_sampling);
+        rm->SetUserAction(static_cast<G4UserSteppingAction*>(profiler));
+        G4UserTrackingAction* tracking = const_cast<G4UserTrackingAction*>(rm->GetUserTrackingAction());
+        rm->SetUserAction(new TS01_Profiler::Tracking(profiler, tracking));
+    }
+    profiler->SetEnabled(on);
+}
+
+void TS01_RunAction::SetProfileSampling(G4int period)
+{
+    profile_sampling = period;
+    if (profiler) profiler->SetSamplingPeriod(period);
+}
+
+void TS01_RunAction::BeginOfRunAction(const G4Run* aRun)
+{
+    if (IsMaster())
+    {
+        TS01_Bench::Instance()->BeginRun();
+        TS01_Telemetry::Instance()->BeginRun(aRun->GetRunID(), aRun->GetNumberOfEventToBeProcessed());
+        // Acceptance tables are not part of the checkpointed results
+        TS01_Checkpoint::Instance()->BeginRun(aRun->GetRunID(), GetAcceptanceBuild() == NULL);
+    }
+    
+    // Physics tables have been built (or retrieved) by now
+    if (G4Threading::IsMasterThread())
+    {
+        const TS01_PhysicsList* physics = static_cast<const TS01_PhysicsList*>(
+            G4RunManager::GetRunManager()->GetUserPhysicsList());
+        const_cast<TS01_PhysicsList*>(physics)->StorePhysicsCache();
+    }
+    
+    // Hits are only seen on threads that process events
+    if (G4RunManager::GetRunManager()->GetRunManagerType() == G4RunManager::masterRM) return;
+    
+    TS01_Checkpoint::Instance()->BeginThreadRun();
+    TS01_Bench::Instance()->BeginThreadRun();
+    
+    TS01_HitWriter* writer = TS01_HitWriter::Instance();
+    writer->SetTextEcho(text_hits);
+    
+    if (hit_file == "")
+    {
+        writer->Close();
+        return;
+    }
+    
+    const G4int thread_id = G4Threading::G4GetThreadId();
+    G4String file_name = hit_file;
+    if (thread_id >= 0)
+    {
+        std::ostringstream os;
+        os << hit_file << ".t" << thread_id;
+        file_name = os.str();
+    }
+    writer->Open(file_name);
+    
+    const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    
+    TS01_HitFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.fiber_mode = det->IsFiber() ? 1 : 0;
+    header.num_fiber  = det->GetNumFiber();
+    header.fiber_dia  = det->GetFiberDiameter() / CLHEP::mm;
+    header.det_radius = det->GetDetectorRadius() / CLHEP::cm;
+    header.run_id     = aRun->GetRunID();
+    header.thread_id  = thread_id;
+    writer->BeginRun(header);
+}
+
+void TS01_RunAction::EndOfRunAction(const G4Run* aRun)
+{
+    TS01_HitWriter::Instance()->EndRun();
+    if (G4RunManager::GetRunManager()->GetRunManagerType() != G4RunManager::masterRM)
+        TS01_Checkpoint::Instance()->EndThreadRun(static_cast<const TS01_Run*>(aRun));
+    
+    // Workers only contribute to the master run through TS01_Run::Merge
+    if (!IsMaster()) return;
+
+    // Results carried over from a resumed checkpoint are added last
+    TS01_Run* run = static_cast<TS01_Run*>(const_cast<G4Run*>(aRun));
+    TS01_Checkpoint::Instance()->EndRun(run);
+    TS01_Bench::Instance()->EndRun(run);
+    TS01_Telemetry::Instance()->EndRun();
+    TS01_PrimaryFile::FlushOutput();
+    if (summary_file != "") WriteSummary(run);
+    
+    if (run->GetAcceptance())
+    {
+        const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+            G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        if (run->GetAcceptance()->Write(acceptance_file, det))
+            G4cout << "Acceptance table written to " << acceptance_file << ", "
+                   << run->GetNumberOfEvent() / (G4double) acceptance.GetNumberOfBins()
+                   << " injections/bin" << G4endl;
+    }
+    
+    if (!run->GetProfile().IsEmpty()) run->GetProfile().Print(profile_top);
+    
+    const G4int n = run->GetDetectorEvents();
+    if (n == 0) return;
+
+    const G4double mu_u = run->GetUnweightedHits() / n;
+    const G4double mu_w = run->GetWeightedHits() / n;
+    const G4double sd_u = sqrt(fmax(run->GetUnweightedHits2() / n - mu_u*mu_u, 0.0));
+    const G4double sd_w = sqrt(fmax(run->GetWeightedHits2() / n - mu_w*mu_w, 0.0));
+
+    // Run totals, same columns as SD-W plus the number of events
+    G4cout << "SD-T " << n << " "
+           << run->GetUnweightedHits() << " " << run->GetWeightedHits() << G4endl;
+    G4cout << "Run " << aRun->GetRunID() << ": " << n << " events, "
+           << "hits/event " << mu_u << " +/- " << sd_u << ", "
+           << "QE-weighted hits/event " << mu_w << " +/- " << sd_w << G4endl;
+    
+    const G4long seen = run->GetCullCount(TS01_Run::kCullSeen);
+    if (seen > 0)
+    {
+        const G4long geom = run->GetCullCount(TS01_Run::kCullGeometry);
+        const G4long path = run->GetCullCount(TS01_Run::kCullPath);
+        G4cout << "Culling: " << seen << " optical photons, "
+               << geom << " missed the sensors, " << path << " beyond the path cut ("
+               << 100.0 * (geom + path) / seen << "%)";
+        if (run->GetCullCount(TS01_Run::kCullDetected) > 0)
+            G4cout << ", " << run->GetCullCount(TS01_Run::kCullDetected)
+                   << " culled photons were detected";
+        G4cout << G4endl;
+    }
+    
+    // Weighted photons: n_eff = (sum w)^2 / sum w^2 detected photons carry
+    // the statistics, against sum w for unit weights
+    const G4long thin_seen = run->GetThinCount(TS01_Run::kThinSeen);
+    if (thin_seen > 0 && run->GetHitWeight2() > 0.0)
+    {
+        const G4long   kept  = run->GetThinCount(TS01_Run::kThinKept);
+        const G4double sum_w = run->GetHitWeight();
+        const G4double n_eff = sum_w * sum_w / run->GetHitWeight2();
+        G4cout << "Thinning: " << kept << " of " << thin_seen << " Cherenkov photons tracked ("
+               << 100.0 * kept / thin_seen << "%), detected weight " << sum_w
+               << ", effective photons " << n_eff << ", variance x" << sum_w / n_eff << G4endl;
+    }
+
+    // Light yield of tracked against parametrised cascades (/ts01/cascade/),
+    // to be compared between runs of the same source with SD-W
+    const G4double tracked_light = run->GetLight(TS01_Run::kLightTracked);
+    const G4double cascade_light = run->GetLight(TS01_Run::kLightCascade);
+    const G4double folded_light  = run->GetLight(TS01_Run::kLightFolded);
+    if (tracked_light > 0.0 || cascade_light > 0.0)
+        G4cout << "Cherenkov light: " << tracked_light / n << " tracked + "
+               << cascade_light / n << " parametrised photons/event, "
+               << run->GetCascades() << " cascades parametrised" << G4endl;
+    if (folded_light > 0.0)
+        G4cout << "Cherenkov light: " << folded_light / n
+               << " photons/event folded with the acceptance table" << G4endl;
+    
+    // Parametrised cascades against the last run that tracked them in full
+    const G4double hits_err = sd_w / sqrt((G4double) n);
+    if (run->GetCascades() == 0 && tracked_light > 0.0)
+    {
+        full_em_valid    = true;
+        full_em_light    = tracked_light / n;
+        full_em_hits     = mu_w;
+        full_em_hits_err = hits_err;
+    }
+    else if (run->GetCascades() > 0 && full_em_valid)
+    {
+        const G4double light = (tracked_light + cascade_light) / n;
+        const G4double err   = sqrt(hits_err*hits_err + full_em_hits_err*full_em_hits_err);
+        G4cout << "Cascade validation: light/event " << light << " against " << full_em_light
+               << " in full EM (ratio " << light / full_em_light << "), QE-weighted hits/event "
+               << mu_w << " +/- " << hits_err << " against " << full_em_hits << " +/- "
+               << full_em_hits_err;
+        if (err > 0.0) G4cout << " (" << (mu_w - full_em_hits) / err << " sigma)";
+        G4cout << G4endl;
+    }
+    
+    G4int hit_channels = 0, busiest = -1;
+    G4double all_photons = 0.0;
+    for (G4int c=0; c<run->GetNumberOfChannels(); c++)
+    {
+        if (run->GetChannelEvents(c) == 0) continue;
+        hit_channels++;
+        all_photons += run->GetChannelPhotons(c);
+        if (busiest < 0 || run->GetChannelPhotons(c) > run->GetChannelPhotons(busiest)) busiest = c;
+    }
+    if (hit_channels > 0)
+        G4cout << "Channels: " << hit_channels << " with hits, busiest " << busiest << " with "
+               << 100.0 * run->GetChannelPhotons(busiest) / all_photons << "% of the photons" << G4endl;
+}
+
+void TS01_RunAction::WriteSummary(const TS01_Run* run)
+{
+    // First run of the job truncates, later runs are appended
+    std::ofstream os(summary_file.c_str(), summary_written ? std::ios::app : std::ios::trunc);
+    if (!os)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot write summary file " << summary_file;
+        G4Exception("TS01_RunAction::WriteSummary", "TS01_Output002", JustWarning, msg);
+        return;
+    }
+    summary_written = true;
+    
+    const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    
+    os << "run " << run->GetRunID() << "\n"
+       << "geometry " << (det->IsFiber() ? 1 : 0) << " " << det->GetNumFiber() << " "
+       << det->GetFiberDiameter() / CLHEP::mm << " " << det->GetDetectorRadius() / CLHEP::cm << "\n";
+    run->WriteSummary(os);
+    os << "end\n";
+}
@@ -0,0 +1,235 @@
+//
+//  TS01_RunMessenger.cc
+//  ts_01
+//
+
+#include <sstream>
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4SystemOfUnits.hh"
+#include "TS01_Checkpoint.hh"
+#include "TS01_RunAction.hh"
+#include "TS01_RunMessenger.hh"
+
+TS01_RunMessenger::TS01_RunMessenger(TS01_RunAction* action) :
+    run_action(action)
+{
+    ts01_dir = new G4UIdirectory("/ts01/");
+    ts01_dir->SetGuidance("ts_01 trade study control.");
+    
+    output_dir = new G4UIdirectory("/ts01/output/");
+    output_dir->SetGuidance("Photon hit output.");
+    
+    file_cmd = new G4UIcmdWithAString("/ts01/output/file", this);
+    file_cmd->SetGuidance("Write binary photon hit records to this file.");
+    file_cmd->SetGuidance("Worker threads append .t<thread id> to the name.");
+    file_cmd->SetGuidance("\"none\" disables binary output.");
+    file_cmd->SetParameterName("file", false);
+    file_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    text_cmd = new G4UIcmdWithABool("/ts01/output/text", this);
+    text_cmd->SetGuidance("Echo every hit as an \"SD-S <time> <wl>\" line (debug).");
+    text_cmd->SetParameterName("text", true);
+    text_cmd->SetDefaultValue(true);
+    text_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    histo_dir = new G4UIdirectory("/ts01/histo/");
+    histo_dir->SetGuidance("Thread-local histograms merged at end of run.");
+    
+    summary_cmd = new G4UIcmdWithAString("/ts01/histo/file", this);
+    summary_cmd->SetGuidance("Write run totals and histograms to this file at end of run.");
+    summary_cmd->SetGuidance("\"none\" disables the summary file.");
+    summary_cmd->SetParameterName("file", false);
+    summary_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    const char* names[TS01_Run::kNumHistograms] = {
+        "/ts01/histo/hits", "/ts01/histo/weighted", "/ts01/histo/time", "/ts01/histo/wavelength"
+    };
+    const char* guidance[TS01_Run::kNumHistograms] = {
+        "Binning of hits per event.",
+        "Binning of QE-weighted hits per event.",
+        "Binning of photon arrival time [ns].",
+        "Binning of detected wavelength [nm]."
+    };
+    for (G4int i=0; i<TS01_Run::kNumHistograms; i++)
+    {
+        bin_cmd[i] = new G4UIcommand(names[i], this);
+        bin_cmd[i]->SetGuidance(guidance[i]);
+        bin_cmd[i]->SetParameter(new G4UIparameter("nbins", 'i', false));
+        bin_cmd[i]->SetParameter(new G4UIparameter("low", 'd', false));
+        bin_cmd[i]->SetParameter(new G4UIparameter("high", 'd', false));
+        bin_cmd[i]->AvailableForStates(G4State_PreInit, G4State_Idle);
+    }
+    
+    acceptance_dir = new G4UIdirectory("/ts01/acceptance/");
+    acceptance_dir->SetGuidance("Photon acceptance table and table-driven fast detector.");
+    
+    acc_build_cmd = new G4UIcommand("/ts01/acceptance/build", this);
+    acc_build_cmd->SetGuidance("Replace the primaries by <photons> optical photons per event,");
+    acc_build_cmd->SetGuidance("injected into one table bin per event, and write the table");
+    acc_build_cmd->SetGuidance("to <file> at end of run.  Run a multiple of the bin count.");
+    acc_build_cmd->SetParameter(new G4UIparameter("file", 's', false));
+    G4UIparameter* photons = new G4UIparameter("photons", 'i', true);
+    photons->SetDefaultValue(1000);
+    photons->SetParameterRange("photons > 0");
+    acc_build_cmd->SetParameter(photons);
+    acc_build_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    acc_load_cmd = new G4UIcmdWithAString("/ts01/acceptance/load", this);
+    acc_load_cmd->SetGuidance("Fast detector: read a table and fold every optical photon");
+    acc_load_cmd->SetGuidance("with it at birth instead of tracking it.  SD-W then reports");
+    acc_load_cmd->SetGuidance("expected hits.");
+    acc_load_cmd->SetParameterName("file", false);
+    acc_load_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    acc_off_cmd = new G4UIcmdWithoutParameter("/ts01/acceptance/off", this);
+    acc_off_cmd->SetGuidance("Back to normal generation and full photon tracking.");
+    acc_off_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    acc_bins_cmd = new G4UIcommand("/ts01/acceptance/bins", this);
+    acc_bins_cmd->SetGuidance("Table binning for build mode: <axis> <nbins> <low> <high>");
+    acc_bins_cmd->SetGuidance("rho, z [cm], cosTheta, dPhi [deg] from radial, wavelength [nm].");
+    G4UIparameter* axis = new G4UIparameter("axis", 's', false);
+    axis->SetParameterCandidates("rho z cosTheta dPhi wavelength");
+    acc_bins_cmd->SetParameter(axis);
+    acc_bins_cmd->SetParameter(new G4UIparameter("nbins", 'i', false));
+    acc_bins_cmd->SetParameter(new G4UIparameter("low", 'd', false));
+    acc_bins_cmd->SetParameter(new G4UIparameter("high", 'd', false));
+    acc_bins_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    profile_dir = new G4UIdirectory("/ts01/profile/");
+    profile_dir->SetGuidance("Step profiling by volume, process and particle.");
+    
+    prof_enable_cmd = new G4UIcmdWithABool("/ts01/profile/enable", this);
+    prof_enable_cmd->SetGuidance("Count steps, tracks and sampled wall time and print a ranked");
+    prof_enable_cmd->SetGuidance("report at end of run.  Nothing is installed until first enabled.");
+    prof_enable_cmd->SetParameterName("enable", true);
+    prof_enable_cmd->SetDefaultValue(true);
+    prof_enable_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    prof_sample_cmd = new G4UIcmdWithAnInteger("/ts01/profile/sample", this);
+    prof_sample_cmd->SetGuidance("Time one step in every <period> (0: counts only).");
+    prof_sample_cmd->SetParameterName("period", false);
+    prof_sample_cmd->SetRange("period >= 0");
+    prof_sample_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    prof_top_cmd = new G4UIcmdWithAnInteger("/ts01/profile/top", this);
+    prof_top_cmd->SetGuidance("Rows per table in the end-of-run report.");
+    prof_top_cmd->SetParameterName("rows", false);
+    prof_top_cmd->SetRange("rows > 0");
+    prof_top_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    
+    checkpoint_dir = new G4UIdirectory("/ts01/checkpoint/");
+    checkpoint_dir->SetGuidance("Periodic checkpoints of the run results (ts_01 --resume).");
+    
+    ckpt_file_cmd = new G4UIcmdWithAString("/ts01/checkpoint/file", this);
+    ckpt_file_cmd->SetGuidance("Checkpoint to this file (rewritten in place); \"none\" disables.");
+    ckpt_file_cmd->SetParameterName("file", false);
+    ckpt_file_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    ckpt_file_cmd->SetToBeBroadcasted(false);
+    
+    ckpt_period_cmd = new G4UIcommand("/ts01/checkpoint/period", this);
+    ckpt_period_cmd->SetGuidance("Checkpoint every <events> events, or <seconds> of wall time");
+    ckpt_period_cmd->SetGuidance("if that comes first (0: events only).");
+    G4UIparameter* events = new G4UIparameter("events", 'i', false);
+    events->SetParameterRange("events > 0");
+    ckpt_period_cmd->SetParameter(events);
+    G4UIparameter* seconds = new G4UIparameter("seconds", 'd', true);
+    seconds->SetDefaultValue(0.0);
+    ckpt_period_cmd->SetParameter(seconds);
+    ckpt_period_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    ckpt_period_cmd->SetToBeBroadcasted(false);
+}
+
+TS01_RunMessenger::~TS01_RunMessenger()
+{
+    delete ckpt_period_cmd;
+    delete ckpt_file_cmd;
+    delete checkpoint_dir;
+    delete prof_top_cmd;
+    delete prof_sample_cmd;
+    delete prof_enable_cmd;
+    delete profile_dir;
+    delete acc_bins_cmd;
+    delete acc_off_cmd;
+    delete acc_load_cmd;
+    delete acc_build_cmd;
+    delete acceptance_dir;
+    for (G4int i=0; i<TS01_Run::kNumHistograms; i++) delete bin_cmd[i];
+    delete summary_cmd;
+    delete histo_dir;
+    delete text_cmd;
+    delete file_cmd;
+    delete output_dir;
+    delete ts01_dir;
+}
+
+void TS01_RunMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    if (cmd == file_cmd)
+        run_action->SetHitFile(value == "none" ? G4String("") : value);
+    else if (cmd == text_cmd)
+        run_action->SetTextHits(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == summary_cmd)
+        run_action->SetSummaryFile(value == "none" ? G4String("") : value);
+    else if (cmd == acc_build_cmd)
+    {
+        G4String file;
+        G4int photons = 1000;
+        std::istringstream is(value);
+        is >> file >> photons;
+        run_action->BuildAcceptance(file, photons);
+    }
+    else if (cmd == acc_load_cmd)
+        run_action->LoadAcceptance(value);
+    else if (cmd == acc_off_cmd)
+        run_action->AcceptanceOff();
+    else if (cmd == prof_enable_cmd)
+        run_action->SetProfiling(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == prof_sample_cmd)
+        run_action->SetProfileSampling(G4UIcmdWithAnInteger::GetNewIntValue(value));
+    else if (cmd == prof_top_cmd)
+        run_action->SetProfileTop(G4UIcmdWithAnInteger::GetNewIntValue(value));
+    else if (cmd == ckpt_file_cmd)
+        TS01_Checkpoint::Instance()->SetFile(value == "none" ? G4String("") : value);
+    else if (cmd == ckpt_period_cmd)
+    {
+        G4int events;
+        G4double seconds = 0.0;
+        std::istringstream is(value);
+        is >> events >> seconds;
+        TS01_Checkpoint::Instance()->SetPeriod(events, seconds);
+    }
+    else if (cmd == acc_bins_cmd)
+    {
+        G4String axis;
+        G4int nbins;
+        G4double lo, hi;
+        std::istringstream is(value);
+        is >> axis >> nbins >> lo >> hi;
+        if (axis == "rho")
+            run_action->SetAcceptanceBinning(TS01_AcceptanceTable::kRho, nbins, lo*cm, hi*cm);
+        else if (axis == "z")
+            run_action->SetAcceptanceBinning(TS01_AcceptanceTable::kZ, nbins, lo*cm, hi*cm);
+        else if (axis == "cosTheta")
+            run_action->SetAcceptanceBinning(TS01_AcceptanceTable::kCosTheta, nbins, lo, hi);
+        else if (axis == "dPhi")
+            run_action->SetAcceptanceBinning(TS01_AcceptanceTable::kDPhi, nbins, lo*deg, hi*deg);
+        else
+            run_action->SetAcceptanceBinning(TS01_AcceptanceTable::kWavelength, nbins, lo, hi);
+    }
+    
+    for (G4int i=0; i<TS01_Run::kNumHistograms; i++)
+    {
+        if (cmd != bin_cmd[i]) continue;
+        G4int nbins;
+        G4double lo, hi;
+        std::istringstream is(value);
+        is >> nbins >> lo >> hi;
+        run_action->SetBinning(i, nbins, lo, hi);
+    }
+}
@@ -0,0 +1,134 @@
+//
+//  TS01_SensorBounds.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_SensorBounds.hh"
+
+TS01_SensorBounds::TS01_SensorBounds() :
+    fiber(false),
+    r_in(0.0), r_out(0.0), z_lo(0.0), z_hi(0.0),
+    r_dom(0.0)
+{
+    
+}
+
+void TS01_SensorBounds::Update(const TS01_DetectorConstruction* det, G4double margin)
+{
+    // Fiber ring: annulus around the PMT radius, from the bottom of the
+    // fibers to the back of the PMT bodies
+    fiber = det->IsFiber();
+    const G4double half_width = 0.6*det->GetFiberDiameter() + margin;
+    r_in  = fmax(det->GetDetectorRadius() - half_width, 0.0);
+    r_out = det->GetDetectorRadius() + half_width;
+    z_lo  = -0.5*det->GetFiberLength() - margin;
+    z_hi  =  0.5*det->GetFiberLength() + det->GetPMTFaceLength() + det->GetPMTBodyLength() + margin;
+    r_dom = det->GetDOMRadius() + margin;
+}
+
+G4double TS01_SensorBounds::Distance(const G4ThreeVector& x, const G4ThreeVector& u) const
+{
+    if (!fiber)
+    {
+        const G4double b = x.dot(u);
+        const G4double c = x.mag2() - r_dom*r_dom;
+        if (c <= 0.0) return 0.0;
+        if (b >= 0.0) return -1.0;
+        const G4double disc = b*b - c;
+        if (disc < 0.0) return -1.0;
+        return -b - sqrt(disc);
+    }
+
+    // Ray parameter interval inside the z slab ...
+    G4double t0 = 0.0, t1 = DBL_MAX;
+    if (fabs(u.z()) < 1.0e-12)
+    {
+        if (x.z() < z_lo || x.z() > z_hi) return -1.0;
+    }
+    else
+    {
+        G4double ta = (z_lo - x.z()) / u.z();
+        G4double tb = (z_hi - x.z()) / u.z();
+        if (ta > tb) std::swap(ta, tb);
+        t0 = fmax(t0, ta);
+        t1 = fmin(t1, tb);
+    }
+
+    // ... and inside the outer cylinder
+    const G4double a = u.x()*u.x() + u.y()*u.y();
+    const G4double b = x.x()*u.x() + x.y()*u.y();
+    const G4double c = x.x()*x.x() + x.y()*x.y() - r_out*r_out;
+    if (a < 1.0e-12)
+    {
+        if (c > 0.0) return -1.0;
+    }
+    else
+    {
+        const G4double disc = b*b - a*c;
+        if (disc < 0.0) return -1.0;
+        t0 = fmax(t0, (-b - sqrt(disc)) / a);
+        t1 = fmin(t1, (-b + sqrt(disc)) / a);
+    }
+    if (t0 > t1) return -1.0;
+
+    // rho^2 is convex along the ray, so if both ends of the segment are
+    // inside the inner cylinder the photon passes through the hole
+    const G4double rho0 = (x + t0*u).perp2();
+    const G4double rho1 = (x + t1*u).perp2();
+    if (rho0 < r_in*r_in && rho1 < r_in*r_in) return -1.0;
+
+    return t0;
+}
+
+void TS01_SensorBounds::Distance(size_t n, const G4double* x, const G4double* y, const G4double* z,
+                                 const G4double* ux, const G4double* uy, const G4double* uz,
+                                 G4double* d) const
+{
+    if (!fiber)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            const G4double b    = x[i]*ux[i] + y[i]*uy[i] + z[i]*uz[i];
+            const G4double c    = x[i]*x[i] + y[i]*y[i] + z[i]*z[i] - r_dom*r_dom;
+            const G4double disc = b*b - c;
+            const G4double t    = -b - sqrt(std::max(disc, 0.0));
+            d[i] = c <= 0.0 ? 0.0 : ((b < 0.0) & (disc >= 0.0) ? t : -1.0);
+        }
+        return;
+    }
+    
+    const G4double r_in2 = r_in*r_in;
+    for (size_t i=0; i<n; i++)
+    {
+        // Slab: a nearly horizontal ray gets a huge interval of the right sign
+        const G4double vz = fabs(uz[i]) < 1.0e-12 ? 1.0e-12 : uz[i];
+        const G4double ta = (z_lo - z[i]) / vz;
+        const G4double tb = (z_hi - z[i]) / vz;
+        G4double t0 = std::max(0.0, std::min(ta, tb));
+        G4double t1 = std::max(ta, tb);
+        
+        // Outer cylinder; a vertical ray is either always inside or never
+        const G4double a    = ux[i]*ux[i] + uy[i]*uy[i];
+        const G4double b    = x[i]*ux[i] + y[i]*uy[i];
+        const G4double c    = x[i]*x[i] + y[i]*y[i] - r_out*r_out;
+        const G4double disc = b*b - a*c;
+        const G4double sq   = sqrt(std::max(disc, 0.0));
+        const G4double inva = 1.0 / std::max(a, 1.0e-12);
+        const G4int    vert = a < 1.0e-12;
+        const G4double lo   = vert ? (c > 0.0 ? DBL_MAX : -DBL_MAX) : (disc < 0.0 ? DBL_MAX : (-b - sq)*inva);
+        const G4double hi   = vert ? DBL_MAX : (disc < 0.0 ? -DBL_MAX : (-b + sq)*inva);
+        t0 = std::max(t0, lo);
+        t1 = std::min(t1, hi);
+        
+        // Through the hole if both ends are inside the inner cylinder
+        const G4double x0 = x[i] + t0*ux[i], y0 = y[i] + t0*uy[i];
+        const G4double x1 = x[i] + t1*ux[i], y1 = y[i] + t1*uy[i];
+        const G4int hole  = (x0*x0 + y0*y0 < r_in2) & (x1*x1 + y1*y1 < r_in2);
+        d[i] = (t0 > t1) | hole ? -1.0 : t0;
+    }
+}
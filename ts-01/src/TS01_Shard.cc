@@ -0,0 +1,63 @@
+//
+//  TS01_Shard.cc
+//  ts_01
+//
+
+#include <stdint.h>
+
+#include "G4Event.hh"
+#include "G4RunManager.hh"
+#include "Randomize.hh"
+#include "TS01_Shard.hh"
+
+namespace
+{
+    uint64_t SplitMix64(uint64_t k)
+    {
+        k += 0x9E3779B97F4A7C15ULL;
+        k = (k ^ (k >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        k = (k ^ (k >> 27)) * 0x94D049BB133111EBULL;
+        return k ^ (k >> 31);
+    }
+}
+
+TS01_Shard* TS01_Shard::Instance()
+{
+    static TS01_Shard* instance = NULL;
+    if (instance == NULL) instance = new TS01_Shard;
+    return instance;
+}
+
+TS01_Shard::TS01_Shard() :
+    seed(0),
+    first_event(0),
+    num_events(-1)
+{
+
+}
+
+G4bool TS01_Shard::BeginEvent(G4Event* evt, G4int run_id) const
+{
+    G4RunManager* rm = G4RunManager::GetRunManager();
+    const G4int local = evt->GetEventID();
+    const G4int id    = first_event + local;
+
+    // Event IDs are handed out in order, so every later event of the
+    // thread is past the end as well
+    if ((num_events >= 0 && local >= num_events) || id >= rm->GetNumberOfEventsToBeProcessed())
+    {
+        evt->SetEventAborted();
+        rm->AbortRun(true);
+        return false;
+    }
+    evt->SetEventID(id);
+
+    // Two non-zero 31-bit seeds, as the MT run manager uses
+    const uint64_t k = SplitMix64(SplitMix64(SplitMix64((uint64_t) seed) ^ (uint64_t) run_id) ^ (uint64_t) id);
+    long seeds[3];
+    seeds[0] = 1 + (long) ((k & 0xFFFFFFFFULL) % 0x7FFFFFFEULL);
+    seeds[1] = 1 + (long) ((k >> 32) % 0x7FFFFFFEULL);
+    seeds[2] = 0;
+    G4Random::setTheSeeds(seeds, -1);
+    return true;
+}
@@ -0,0 +1,184 @@
+//
+//  TS01_SpectralResponse.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "TS01_SpectralResponse.hh"
+
+// Bialkali PMT QE starts at 300 nm goes to 690 nm in steps of 10 n,
+static const G4double QE[] = {
+    1.773,  6.173,  11.074, 16.593, 20.03,  // 300 nm .. 340 nm
+    22.368, 23.366, 24.242, 24.39 , 24.843, // 350 nm .. 390 nm
+    24.969, 25.323, 24.879, 23.809, 22.959, // 400 nm .. 440 nm
+    22.204, 21.097, 19.572, 18.351, 17.425, // 450 nm .. 490 nm
+    16.655, 15.647, 13.518, 10.752,  8.71,  // 500 nm .. 540 nm
+    7.473 ,  6.587,  5.736,  4.906,  4.067, // 550 nm .. 590 nm
+    3.289 ,  2.553,  1.878,  1.211,  0.835, // 600 nm .. 640 nm
+    0.533 ,  0.304,  0.175,  0.093,  0.048  // 650 nm .. 690 nm
+};
+
+TS01_SpectralResponse::TS01_SpectralResponse(const G4String& n) :
+    name(n),
+    source("flat")
+{
+    std::vector<G4double> wl(2), one(2, 1.0);
+    wl[0] = 300.0;
+    wl[1] = 700.0;
+    SetCurve(wl, one, one);
+}
+
+TS01_SpectralResponse* TS01_SpectralResponse::Bialkali(const G4String& n)
+{
+    // The 690 nm value is held to 700 nm, the edge of the original
+    // 10 nm binned weights, so no hit below 700 nm loses its weight
+    const size_t n_qe = sizeof(QE)/sizeof(QE[0]);
+    std::vector<G4double> wl(n_qe + 1), qe(n_qe + 1), ce(n_qe + 1, 1.0);
+    for (size_t i=0; i<n_qe; i++)
+    {
+        wl[i] = 300.0 + 10.0*i;
+        qe[i] = QE[i]*0.01;
+    }
+    wl[n_qe] = 700.0;
+    qe[n_qe] = qe[n_qe-1];
+    TS01_SpectralResponse* r = new TS01_SpectralResponse(n);
+    r->SetCurve(wl, qe, ce);
+    r->source = "bialkali";
+    return r;
+}
+
+void TS01_SpectralResponse::SetCurve(const std::vector<G4double>& wl,
+                                     const std::vector<G4double>& qe,
+                                     const std::vector<G4double>& ce)
+{
+    wl_lo = wl.front();
+    wl_hi = wl.back();
+
+    // Linear interpolation onto the 1 nm grid; the last point is repeated
+    // so Weight() can always read eff[j+1]
+    const size_t n = (size_t) floor(wl_hi - wl_lo) + 1;
+    eff.resize(n + 1);
+    size_t k = 0;
+    for (size_t j=0; j<n; j++)
+    {
+        const G4double x = wl_lo + j;
+        while (k + 2 < wl.size() && wl[k+1] < x) k++;
+        const G4double f = (wl[k+1] > wl[k]) ? (x - wl[k]) / (wl[k+1] - wl[k]) : 0.0;
+        eff[j] = (qe[k] + f*(qe[k+1] - qe[k])) * (ce[k] + f*(ce[k+1] - ce[k]));
+    }
+    eff[n] = eff[n-1];
+}
+
+G4double TS01_SpectralResponse::GetMaxEfficiency() const
+{
+    return *std::max_element(eff.begin(), eff.end());
+}
+
+G4bool TS01_SpectralResponse::Load(const G4String& file)
+{
+    std::ifstream is(file.c_str());
+    if (!is)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot read response curve " << file;
+        G4Exception("TS01_SpectralResponse::Load", "TS01_Response001", JustWarning, msg);
+        return false;
+    }
+
+    std::vector<std::pair<G4double, std::pair<G4double, G4double> > > points;
+    std::string line;
+    while (std::getline(is, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ls(line);
+        G4double wl, qe, ce = 1.0;
+        if (!(ls >> wl >> qe)) continue;
+        ls >> ce;
+        points.push_back(std::make_pair(wl, std::make_pair(qe, ce)));
+    }
+    std::sort(points.begin(), points.end());
+
+    if (points.size() < 2 || points.back().first - points.front().first < 1.0)
+    {
+        G4ExceptionDescription msg;
+        msg << "Response curve " << file << " needs at least two points 1 nm apart";
+        G4Exception("TS01_SpectralResponse::Load", "TS01_Response002", JustWarning, msg);
+        return false;
+    }
+
+    std::vector<G4double> wl, qe, ce;
+    for (size_t i=0; i<points.size(); i++)
+    {
+        wl.push_back(points[i].first);
+        qe.push_back(points[i].second.first);
+        ce.push_back(points[i].second.second);
+    }
+    SetCurve(wl, qe, ce);
+    source = file;
+    return true;
+}
+
+G4bool TS01_SpectralResponse::LoadGains(const G4String& file)
+{
+    std::ifstream is(file.c_str());
+    if (!is)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot read channel gains " << file;
+        G4Exception("TS01_SpectralResponse::LoadGains", "TS01_Response001", JustWarning, msg);
+        return false;
+    }
+
+    gains.clear();
+    std::string line;
+    while (std::getline(is, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ls(line);
+        G4int channel;
+        G4double gain;
+        if (!(ls >> channel >> gain) || channel < 0) continue;
+        if (channel >= (G4int) gains.size()) gains.resize(channel + 1, 1.0);
+        gains[channel] = gain;
+    }
+    return true;
+}
+
+void TS01_SpectralResponse::Weight(size_t n, const G4double* wl, const G4int* channel,
+                                   G4double* w) const
+{
+    const G4double* e    = &eff[0];
+    const G4double  last = eff.size() - 2;
+    for (size_t i=0; i<n; i++)
+    {
+        const G4double x  = fmin(fmax(wl[i] - wl_lo, 0.0), last);
+        const size_t   j  = (size_t) x;
+        const G4double in = (wl[i] >= wl_lo && wl[i] <= wl_hi) ? 1.0 : 0.0;
+        w[i] = in * (e[j] + (x - j)*(e[j+1] - e[j]));
+    }
+    if (gains.empty()) return;
+    for (size_t i=0; i<n; i++) w[i] *= GetGain(channel[i]);
+}
+
+void TS01_SpectralResponse::Print() const
+{
+    G4double peak = 0.0;
+    for (size_t j=0; j<eff.size(); j++) peak = fmax(peak, eff[j]);
+    G4cout << "response " << name << ": " << source << ", " << wl_lo << "-" << wl_hi
+           << " nm, peak " << peak << ", " << gains.size() << " channel gains" << G4endl;
+}
+
+void TS01_SpectralResponse::Describe(std::ostream& os) const
+{
+    const std::streamsize precision = os.precision(17);
+    os << "response " << wl_lo << " " << wl_hi;
+    for (size_t j=0; j<eff.size(); j++) os << " " << eff[j];
+    os << " gains";
+    for (size_t c=0; c<gains.size(); c++) os << " " << gains[c];
+    os << "\n";
+    os.precision(precision);
+}
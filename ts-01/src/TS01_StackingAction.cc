@@ -0,0 +1,262 @@
+//
+//  TS01_StackingAction.cc
+//  ts_01
+//
+
+#include <math.h>
+#include <algorithm>
+
+#include "G4RunManager.hh"
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4SDManager.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Electron.hh"
+#include "G4ProcessManager.hh"
+#include "Randomize.hh"
+#include "TS01_PhotoSD.hh"
+#include "TS01_RunAction.hh"
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_Run.hh"
+#include "TS01_Cerenkov.hh"
+#include "TS01_PhotonPool.hh"
+#include "TS01_PrimaryGenerator.hh"
+#include "TS01_IceModel.hh"
+#include "TS01_Telemetry.hh"
+#include "TS01_StackingAction.hh"
+#include "TS01_StackingMessenger.hh"
+
+TS01_StackingAction::TS01_StackingAction() :
+    G4UserStackingAction(),
+    enabled(false),
+    validate(false),
+    margin(1.0*cm),
+    max_abs_lengths(0.0),
+    ice_abs(NULL),
+    subevent(false),
+    cull_event(false),
+    subevent_event(false),
+    layered_warned(false),
+    batch_size(4096),
+    reinjecting(false),
+    record_only(false),
+    ice(NULL),
+    thinning(false),
+    thin_factor(1.0),
+    thin_p(1.0),
+    cerenkov(NULL),
+    cascade(NULL),
+    run(NULL),
+    acceptance(NULL),
+    photo_sd(NULL),
+    telemetry(TS01_Telemetry::Instance())
+{
+    messenger = new TS01_StackingMessenger(this);
+}
+
+TS01_StackingAction::~TS01_StackingAction()
+{
+    delete messenger;
+}
+
+void TS01_StackingAction::PrepareNewEvent()
+{
+    culled.clear();
+    batch.Clear();
+    record_only = TS01_PrimaryGenerator::IsRecordOnly();
+    telemetry->BeginEvent(G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID());
+    
+    G4RunManager* rm = G4RunManager::GetRunManager();
+    run = static_cast<TS01_Run*>(rm->GetNonConstCurrentRun());
+    const TS01_DetectorConstruction* det = static_cast<const TS01_DetectorConstruction*>(
+        rm->GetUserDetectorConstruction());
+    
+    // Responses can be reassigned between runs
+    if (thinning) thin_p = std::min(1.0, thin_factor * det->GetMaxEfficiency());
+    
+    acceptance = static_cast<const TS01_RunAction*>(rm->GetUserRunAction())->GetAcceptanceFast();
+    
+    // With a table, Cherenkov light is folded with it step by step and
+    // never reaches the stack
+    TS01_Cerenkov* fold = dynamic_cast<TS01_Cerenkov*>(
+        G4Electron::Definition()->GetProcessManager()->GetProcess("TS01Cerenkov"));
+    
+    // Culling and sub-event propagation follow straight lines through the
+    // ice, so they are skipped (for this event, the settings stay) in the
+    // layered ice
+    cull_event     = enabled;
+    subevent_event = subevent;
+    if ((cull_event || (subevent_event && !acceptance)) && TS01_IceModel::Instance()->IsLoaded())
+    {
+        if (!layered_warned)
+        {
+            G4ExceptionDescription msg;
+            msg << "Photons scatter in the layered ice, culling and sub-event propagation skipped";
+            G4Exception("TS01_StackingAction::PrepareNewEvent", "TS01_Stacking001", JustWarning, msg);
+            layered_warned = true;
+        }
+        cull_event = false;
+        if (!acceptance) subevent_event = false;
+    }
+    
+    if (subevent_event)
+    {
+        // One draw per event keys the photon streams of the whole event
+        const G4int event_id = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+        batch.SetEventKey(((uint64_t) (G4UniformRand() * 4294967296.0) << 32) | (uint32_t) event_id);
+        if (!batch.IsIceLoaded() && !batch.LoadIce()) subevent_event = false;
+        ice = G4Material::GetMaterial("Ice");
+    }
+    
+    if (acceptance)
+    {
+        // The SD of this thread survives geometry rebuilds
+        photo_sd = static_cast<TS01_PhotoSD*>(
+            G4SDManager::GetSDMpointer()->FindSensitiveDetector("/TS01/Photomultiplier", false));
+        if (fold) fold->SetAcceptance(acceptance, photo_sd);
+        return;
+    }
+    if (fold) fold->SetAcceptance(NULL, NULL);
+    
+    if (!cull_event && !subevent_event) return;
+
+    bounds.Update(det, margin);
+
+    if (ice_abs == NULL)
+    {
+        G4Material* ice = G4Material::GetMaterial("Ice");
+        if (ice && ice->GetMaterialPropertiesTable())
+            ice_abs = ice->GetMaterialPropertiesTable()->GetProperty("ABSLENGTH");
+    }
+}
+
+G4ClassificationOfNewTrack TS01_StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+    // Primaries are only being written to file
+    if (record_only) return fKill;
+    
+    if (track->GetDefinition() != G4OpticalPhoton::OpticalPhotonDefinition()) return fUrgent;
+    
+    // Photons handed back by NewStage() have been dealt with
+    if (reinjecting) return fUrgent;
+    telemetry->CountPhoton();
+    run->CountWork(TS01_Run::kWorkPhotons, 1);
+    
+    // Cherenkov light, tracked or from parametrised cascades
+    const G4VProcess* creator = track->GetCreatorProcess();
+    if (creator && creator != cerenkov && creator != cascade)
+    {
+        if (cerenkov == NULL && creator->GetProcessName() == "Cerenkov") cerenkov = creator;
+        if (cascade == NULL && creator->GetProcessName() == "TS01Cascade") cascade = creator;
+    }
+    const G4bool cherenkov_light = creator && (creator == cerenkov || creator == cascade);
+    if (cherenkov_light)
+        run->CountLight(creator == cascade ? TS01_Run::kLightCascade : TS01_Run::kLightTracked,
+                        track->GetWeight());
+    
+    if (thinning && thin_p < 1.0)
+    {
+        if (cherenkov_light)
+        {
+            run->CountThin(TS01_Run::kThinSeen);
+            if (G4UniformRand() >= thin_p) return fKill;
+            run->CountThin(TS01_Run::kThinKept);
+            const_cast<G4Track*>(track)->SetWeight(track->GetWeight() / thin_p);
+        }
+    }
+    
+    if (subevent_event && (acceptance || (track->GetVolume() &&
+                     track->GetVolume()->GetLogicalVolume()->GetMaterial() == ice)))
+    {
+        batch.Add(track);
+        return fKill;
+    }
+    
+    if (acceptance)
+    {
+        G4double p_u, p_w;
+        acceptance->Lookup(track->GetPosition(), track->GetMomentumDirection(),
+                           1240.0*eV / track->GetKineticEnergy(), p_u, p_w);
+        if (photo_sd) photo_sd->AddExpected(track->GetWeight() * p_u, track->GetWeight() * p_w);
+        return fKill;
+    }
+    
+    if (!cull_event) return fUrgent;
+
+    run->CountCull(TS01_Run::kCullSeen);
+
+    // Daughters of a flagged photon (e.g. re-emission) inherit the flag
+    if (validate && culled.count(track->GetParentID()))
+    {
+        culled.insert(track->GetTrackID());
+        return fUrgent;
+    }
+
+    const G4double d = bounds.Distance(track->GetPosition(), track->GetMomentumDirection());
+
+    G4int reason = -1;
+    if (d < 0.0)
+        reason = TS01_Run::kCullGeometry;
+    else if (max_abs_lengths > 0.0 && ice_abs != NULL &&
+             d > max_abs_lengths * ice_abs->Value(track->GetKineticEnergy()))
+        reason = TS01_Run::kCullPath;
+
+    if (reason < 0) return fUrgent;
+
+    run->CountCull(reason);
+    if (!validate) return fKill;
+
+    culled.insert(track->GetTrackID());
+    return fUrgent;
+}
+
+void TS01_StackingAction::NewStage()
+{
+    const size_t n = batch.Size();
+    if (n == 0) return;
+    
+    // Task boundaries depend only on the batch size, and partial sums are
+    // added in task order, so results do not depend on the pool size
+    const size_t n_tasks = (n + batch_size - 1) / batch_size;
+    TS01_PhotonPool* pool = TS01_PhotonPool::Instance();
+    TS01_PhotonBatch& photons = batch;
+    const size_t step = batch_size;
+    
+    if (acceptance)
+    {
+        const TS01_AcceptanceTable& table = *acceptance;
+        std::vector<G4double> p_u(n_tasks), p_w(n_tasks);
+        pool->Run(n_tasks, [&](size_t k) {
+            photons.Fold(k*step, std::min(n, (k + 1)*step), table, p_u[k], p_w[k]);
+        });
+        G4double sum_u = 0.0, sum_w = 0.0;
+        for (size_t k=0; k<n_tasks; k++)
+        {
+            sum_u += p_u[k];
+            sum_w += p_w[k];
+        }
+        if (photo_sd) photo_sd->AddExpected(sum_u, sum_w);
+    }
+    else
+    {
+        const TS01_SensorBounds& sensor = bounds;
+        pool->Run(n_tasks, [&](size_t k) {
+            photons.Propagate(k*step, std::min(n, (k + 1)*step), sensor);
+        });
+        
+        // Re-emitted photons from these come back through ClassifyNewTrack
+        // and make up the next batch
+        reinjecting = true;
+        for (size_t i=0; i<n; i++)
+            if (batch.IsAlive(i)) stackManager->PushOneTrack(batch.MakeTrack(i));
+        reinjecting = false;
+    }
+    batch.Clear();
+}
@@ -0,0 +1,120 @@
+//
+//  TS01_StackingMessenger.cc
+//  ts_01
+//
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "TS01_PhotonPool.hh"
+#include "TS01_StackingAction.hh"
+#include "TS01_StackingMessenger.hh"
+
+TS01_StackingMessenger::TS01_StackingMessenger(TS01_StackingAction* s) :
+    stacking(s)
+{
+    cull_dir = new G4UIdirectory("/ts01/cull/");
+    cull_dir->SetGuidance("Culling of optical photons that cannot reach a sensor.");
+
+    enable_cmd = new G4UIcmdWithABool("/ts01/cull/enable", this);
+    enable_cmd->SetGuidance("Kill optical photons that miss the sensor bounding volume.");
+    enable_cmd->SetParameterName("enable", true);
+    enable_cmd->SetDefaultValue(true);
+
+    validate_cmd = new G4UIcmdWithABool("/ts01/cull/validate", this);
+    validate_cmd->SetGuidance("Track culled photons anyway and count the ones that are detected.");
+    validate_cmd->SetGuidance("The count should stay zero; SD-W is then unchanged by culling.");
+    validate_cmd->SetParameterName("validate", true);
+    validate_cmd->SetDefaultValue(true);
+
+    margin_cmd = new G4UIcmdWithADoubleAndUnit("/ts01/cull/margin", this);
+    margin_cmd->SetGuidance("Safety margin added around the sensor bounding volume.");
+    margin_cmd->SetParameterName("margin", false);
+    margin_cmd->SetDefaultUnit("cm");
+    margin_cmd->SetRange("margin >= 0");
+
+    abs_cmd = new G4UIcmdWithADouble("/ts01/cull/maxAbsLengths", this);
+    abs_cmd->SetGuidance("Also cull photons farther than this many ice absorption lengths");
+    abs_cmd->SetGuidance("from the sensor bounding volume (0 disables the cut).");
+    abs_cmd->SetParameterName("n", false);
+    abs_cmd->SetRange("n >= 0");
+    
+    subevent_dir = new G4UIdirectory("/ts01/subevent/");
+    subevent_dir->SetGuidance("Parallel processing of the optical photons within one event.");
+    
+    sub_enable_cmd = new G4UIcmdWithABool("/ts01/subevent/enable", this);
+    sub_enable_cmd->SetGuidance("Batch optical photons born in the ice and propagate them to the");
+    sub_enable_cmd->SetGuidance("sensors on the photon pool; survivors are tracked as usual.");
+    sub_enable_cmd->SetGuidance("With an acceptance table loaded the batch is folded instead.");
+    sub_enable_cmd->SetParameterName("enable", true);
+    sub_enable_cmd->SetDefaultValue(true);
+    
+    sub_threads_cmd = new G4UIcmdWithAnInteger("/ts01/subevent/threads", this);
+    sub_threads_cmd->SetGuidance("Photon pool threads, shared by all event threads (default: the");
+    sub_threads_cmd->SetGuidance("cores left over by the event threads); 0 runs the batch kernels");
+    sub_threads_cmd->SetGuidance("on the event thread.");
+    sub_threads_cmd->SetGuidance("Only effective before the first sub-event batch.");
+    sub_threads_cmd->SetParameterName("threads", false);
+    sub_threads_cmd->SetRange("threads >= 0");
+    
+    sub_batch_cmd = new G4UIcmdWithAnInteger("/ts01/subevent/batch", this);
+    sub_batch_cmd->SetGuidance("Photons per pool task.  Results depend on this, not on the");
+    sub_batch_cmd->SetGuidance("number of threads.");
+    sub_batch_cmd->SetParameterName("photons", false);
+    sub_batch_cmd->SetRange("photons > 0");
+    
+    thin_dir = new G4UIdirectory("/ts01/thin/");
+    thin_dir->SetGuidance("Super-photons: thinning of Cherenkov photons at generation.");
+    
+    thin_enable_cmd = new G4UIcmdWithABool("/ts01/thin/enable", this);
+    thin_enable_cmd->SetGuidance("Keep Cherenkov photons with probability p = factor x the largest");
+    thin_enable_cmd->SetGuidance("QE x CE of the responses in use, at weight 1/p.  SD-W sums the");
+    thin_enable_cmd->SetGuidance("weights; the run report gives the effective photon count.");
+    thin_enable_cmd->SetParameterName("enable", true);
+    thin_enable_cmd->SetDefaultValue(true);
+    
+    thin_factor_cmd = new G4UIcmdWithADouble("/ts01/thin/factor", this);
+    thin_factor_cmd->SetGuidance("Scale of the survival probability (p is capped at 1).");
+    thin_factor_cmd->SetParameterName("factor", false);
+    thin_factor_cmd->SetRange("factor > 0");
+}
+
+TS01_StackingMessenger::~TS01_StackingMessenger()
+{
+    delete thin_factor_cmd;
+    delete thin_enable_cmd;
+    delete thin_dir;
+    delete sub_batch_cmd;
+    delete sub_threads_cmd;
+    delete sub_enable_cmd;
+    delete subevent_dir;
+    delete abs_cmd;
+    delete margin_cmd;
+    delete validate_cmd;
+    delete enable_cmd;
+    delete cull_dir;
+}
+
+void TS01_StackingMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    if (cmd == enable_cmd)
+        stacking->SetEnabled(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == validate_cmd)
+        stacking->SetValidation(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == margin_cmd)
+        stacking->SetMargin(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(value));
+    else if (cmd == abs_cmd)
+        stacking->SetMaxAbsLengths(G4UIcmdWithADouble::GetNewDoubleValue(value));
+    else if (cmd == sub_enable_cmd)
+        stacking->SetSubEvent(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == sub_threads_cmd)
+        TS01_PhotonPool::SetNumberOfThreads(G4UIcmdWithAnInteger::GetNewIntValue(value));
+    else if (cmd == sub_batch_cmd)
+        stacking->SetBatchSize(G4UIcmdWithAnInteger::GetNewIntValue(value));
+    else if (cmd == thin_enable_cmd)
+        stacking->SetThinning(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == thin_factor_cmd)
+        stacking->SetThinFactor(G4UIcmdWithADouble::GetNewDoubleValue(value));
+}
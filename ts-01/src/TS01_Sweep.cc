@@ -0,0 +1,73 @@
+//
+//  TS01_Sweep.cc
+//  ts_01
+//
+
+#include <fstream>
+
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "TS01_DetectorConstruction.hh"
+#include "TS01_Run.hh"
+#include "TS01_Sweep.hh"
+#include "TS01_SweepMessenger.hh"
+
+TS01_Sweep::TS01_Sweep(TS01_DetectorConstruction* det) :
+    detector(det),
+    output_file("sweep.dat")
+{
+    messenger = new TS01_SweepMessenger(this);
+}
+
+TS01_Sweep::~TS01_Sweep()
+{
+    delete messenger;
+}
+
+void TS01_Sweep::List() const
+{
+    for (size_t i=0; i<points.size(); i++)
+    {
+        const Point& p = points[i];
+        G4cout << "sweep point " << i << ": " << (p.fiber ? "F" : "D")
+               << " r=" << p.radius / cm << " cm d=" << p.fiber_dia / mm
+               << " mm n=" << p.num_fiber << G4endl;
+    }
+}
+
+void TS01_Sweep::BeamOn(G4int n_events)
+{
+    std::ofstream os(output_file.c_str());
+    if (!os)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot write sweep output " << output_file;
+        G4Exception("TS01_Sweep::BeamOn", "TS01_Sweep001", JustWarning, msg);
+        return;
+    }
+    os << "# point mode radius_cm fiber_dia_mm n_fiber events hits weighted_hits"
+          " hits_per_event weighted_per_event\n";
+    
+    G4RunManager* rm = G4RunManager::GetRunManager();
+    
+    for (size_t i=0; i<points.size(); i++)
+    {
+        const Point& p = points[i];
+        detector->SetGeometry(p.fiber, p.num_fiber, p.fiber_dia, p.radius);
+        
+        // Wipe and rebuild the volume/solid/surface stores only; workers
+        // pick up the new geometry through /run/reinitializeGeometry
+        rm->ReinitializeGeometry(true);
+        rm->BeamOn(n_events);
+        
+        const TS01_Run* run = static_cast<const TS01_Run*>(rm->GetCurrentRun());
+        if (run == NULL) continue;
+        
+        const G4int n = run->GetDetectorEvents();
+        os << i << " " << (p.fiber ? "F" : "D") << " "
+           << p.radius / cm << " " << p.fiber_dia / mm << " " << p.num_fiber << " "
+           << n << " " << run->GetUnweightedHits() << " " << run->GetWeightedHits() << " "
+           << (n > 0 ? run->GetUnweightedHits() / n : 0.0) << " "
+           << (n > 0 ? run->GetWeightedHits() / n : 0.0) << std::endl;
+    }
+}
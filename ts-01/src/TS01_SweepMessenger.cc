@@ -0,0 +1,86 @@
+//
+//  TS01_SweepMessenger.cc
+//  ts_01
+//
+
+#include <sstream>
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4SystemOfUnits.hh"
+#include "TS01_Sweep.hh"
+#include "TS01_SweepMessenger.hh"
+
+TS01_SweepMessenger::TS01_SweepMessenger(TS01_Sweep* s) :
+    sweep(s)
+{
+    sweep_dir = new G4UIdirectory("/ts01/sweep/", false);
+    sweep_dir->SetGuidance("In-process geometry parameter sweep.");
+    
+    add_cmd = new G4UIcommand("/ts01/sweep/add", this);
+    add_cmd->SetGuidance("Add a sweep point: <radius [cm]> <fiber dia. [mm]> <n_fiber> <D|F>");
+    add_cmd->SetParameter(new G4UIparameter("radius", 'd', false));
+    add_cmd->SetParameter(new G4UIparameter("fiber_dia", 'd', false));
+    add_cmd->SetParameter(new G4UIparameter("n_fiber", 'i', false));
+    G4UIparameter* mode = new G4UIparameter("mode", 's', false);
+    mode->SetParameterCandidates("D F");
+    add_cmd->SetParameter(mode);
+    add_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    add_cmd->SetToBeBroadcasted(false);
+    
+    clear_cmd = new G4UIcmdWithoutParameter("/ts01/sweep/clear", this);
+    clear_cmd->SetGuidance("Remove all sweep points.");
+    clear_cmd->SetToBeBroadcasted(false);
+    
+    list_cmd = new G4UIcmdWithoutParameter("/ts01/sweep/list", this);
+    list_cmd->SetGuidance("List the sweep points.");
+    list_cmd->SetToBeBroadcasted(false);
+    
+    file_cmd = new G4UIcmdWithAString("/ts01/sweep/file", this);
+    file_cmd->SetGuidance("Output file with one line per sweep point.");
+    file_cmd->SetParameterName("file", false);
+    file_cmd->SetToBeBroadcasted(false);
+    
+    beam_cmd = new G4UIcmdWithAnInteger("/ts01/sweep/beamOn", this);
+    beam_cmd->SetGuidance("Rebuild the geometry and run <n> events for every sweep point.");
+    beam_cmd->SetParameterName("n", false);
+    beam_cmd->SetRange("n >= 0");
+    beam_cmd->AvailableForStates(G4State_Idle);
+    beam_cmd->SetToBeBroadcasted(false);
+}
+
+TS01_SweepMessenger::~TS01_SweepMessenger()
+{
+    delete beam_cmd;
+    delete file_cmd;
+    delete list_cmd;
+    delete clear_cmd;
+    delete add_cmd;
+    delete sweep_dir;
+}
+
+void TS01_SweepMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    if (cmd == add_cmd)
+    {
+        TS01_Sweep::Point p;
+        G4String mode;
+        std::istringstream is(value);
+        is >> p.radius >> p.fiber_dia >> p.num_fiber >> mode;
+        p.radius    *= cm;
+        p.fiber_dia *= mm;
+        p.fiber      = (mode == "F");
+        sweep->AddPoint(p);
+    }
+    else if (cmd == clear_cmd)
+        sweep->Clear();
+    else if (cmd == list_cmd)
+        sweep->List();
+    else if (cmd == file_cmd)
+        sweep->SetOutputFile(value);
+    else if (cmd == beam_cmd)
+        sweep->BeamOn(G4UIcmdWithAnInteger::GetNewIntValue(value));
+}
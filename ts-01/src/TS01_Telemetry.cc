@@ -0,0 +1,227 @@
+//
+//  TS01_Telemetry.cc
+//  ts_01
+//
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <chrono>
+#include <sstream>
+
+#include "G4Threading.hh"
+#include "TS01_Telemetry.hh"
+
+namespace
+{
+    G4double Now()
+    {
+        return std::chrono::duration<G4double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Current resident set size [MB]; 0 where /proc is not available
+    G4double CurrentRSS()
+    {
+        FILE* fp = fopen("/proc/self/statm", "r");
+        if (fp == NULL) return 0.0;
+        long size = 0, resident = 0;
+        const int n = fscanf(fp, "%ld %ld", &size, &resident);
+        fclose(fp);
+        return n == 2 ? resident * (sysconf(_SC_PAGESIZE) / (1024.0*1024.0)) : 0.0;
+    }
+}
+
+TS01_Telemetry* TS01_Telemetry::Instance()
+{
+    static TS01_Telemetry* instance = NULL;
+    if (instance == NULL) instance = new TS01_Telemetry;
+    return instance;
+}
+
+TS01_Telemetry::TS01_Telemetry() :
+    enabled(false),
+    listen_fd(-1),
+    stop(false),
+    run_id(-1),
+    requested(0),
+    running(false),
+    run_start(0.0),
+    run_end(0.0)
+{
+    for (G4int i=0; i<=kMaxSlots; i++)
+    {
+        Slot& slot = i < kMaxSlots ? slots[i] : overflow;
+        slot.event = -1;
+        slot.events = 0;
+        slot.photons = 0;
+        slot.unweighted = 0.0;
+        slot.weighted = 0.0;
+    }
+}
+
+G4bool TS01_Telemetry::Start(const G4String& path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        G4ExceptionDescription msg;
+        msg << "Telemetry socket path " << path << " is too long";
+        G4Exception("TS01_Telemetry::Start", "TS01_Telemetry001", JustWarning, msg);
+        return false;
+    }
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // A socket left behind by a killed job is replaced, anything else kept
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            G4ExceptionDescription msg;
+            msg << "Telemetry socket path " << path << " exists and is not a socket";
+            G4Exception("TS01_Telemetry::Start", "TS01_Telemetry003", JustWarning, msg);
+            return false;
+        }
+        unlink(path.c_str());
+    }
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, 4) != 0)
+    {
+        G4ExceptionDescription msg;
+        msg << "Cannot listen on " << path << ": " << strerror(errno);
+        G4Exception("TS01_Telemetry::Start", "TS01_Telemetry002", JustWarning, msg);
+        if (listen_fd >= 0) close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    socket_path = path;
+    enabled = true;
+    stop = false;
+    server = std::thread(&TS01_Telemetry::Serve, this);
+    G4cout << "TS01_Telemetry: serving run status on " << path << G4endl;
+    return true;
+}
+
+void TS01_Telemetry::Stop()
+{
+    if (!enabled) return;
+    stop = true;
+    server.join();
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    listen_fd = -1;
+    enabled = false;
+}
+
+void TS01_Telemetry::BeginRun(G4int id, G4int n_events)
+{
+    if (!enabled) return;
+
+    // Workers are idle between runs
+    for (G4int i=0; i<kMaxSlots; i++)
+    {
+        slots[i].event.store(-1, std::memory_order_relaxed);
+        slots[i].events.store(0, std::memory_order_relaxed);
+        slots[i].photons.store(0, std::memory_order_relaxed);
+        slots[i].unweighted.store(0.0, std::memory_order_relaxed);
+        slots[i].weighted.store(0.0, std::memory_order_relaxed);
+    }
+    run_id    = id;
+    requested = n_events;
+    run_start = Now();
+    running   = true;
+}
+
+void TS01_Telemetry::EndRun()
+{
+    if (!enabled) return;
+    run_end = Now();
+    running = false;
+}
+
+void TS01_Telemetry::EndOfEvent(G4double unweighted, G4double weighted)
+{
+    if (!enabled) return;
+    Slot& slot = ThreadSlot();
+    Bump(slot, slot.events, 1);
+    Bump(slot, slot.unweighted, unweighted);
+    Bump(slot, slot.weighted, weighted);
+}
+
+TS01_Telemetry::Slot& TS01_Telemetry::ThreadSlot()
+{
+    // The sequential run manager and the master are thread -1
+    const G4int i = G4Threading::G4GetThreadId() + 1;
+    return i >= 0 && i < kMaxSlots ? slots[i] : overflow;
+}
+
+void TS01_Telemetry::Serve()
+{
+    while (!stop)
+    {
+        struct pollfd pfd;
+        pfd.fd = listen_fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 250) <= 0) continue;
+
+        const int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+        const G4String text = Snapshot();
+        // No SIGPIPE from a client that has gone: EPIPE just drops it
+        size_t done = 0;
+        while (done < text.size())
+        {
+            const ssize_t n = send(fd, text.c_str() + done, text.size() - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += n;
+        }
+        close(fd);
+    }
+}
+
+G4String TS01_Telemetry::Snapshot() const
+{
+    G4long   events = 0, photons = 0;
+    G4double unweighted = 0.0, weighted = 0.0;
+    std::ostringstream threads;
+    for (G4int i=0; i<kMaxSlots; i++)
+    {
+        const G4int  event = slots[i].event.load(std::memory_order_relaxed);
+        const G4long n     = slots[i].events.load(std::memory_order_relaxed);
+        if (event < 0 && n == 0) continue;
+        events     += n;
+        photons    += slots[i].photons.load(std::memory_order_relaxed);
+        unweighted += slots[i].unweighted.load(std::memory_order_relaxed);
+        weighted   += slots[i].weighted.load(std::memory_order_relaxed);
+        threads << (threads.tellp() > 0 ? ", " : "")
+                << "{\"thread\": " << i - 1 << ", \"event\": " << event
+                << ", \"events\": " << n << "}";
+    }
+
+    const G4bool   active  = running;
+    const G4double elapsed = (active ? Now() : run_end.load()) - run_start;
+    const G4double rate    = elapsed > 0.0 ? 1.0 / elapsed : 0.0;
+
+    std::ostringstream os;
+    os << "{\"run\": " << run_id << ", \"running\": " << (active ? "true" : "false")
+       << ", \"events\": " << events << ", \"requested\": " << requested
+       << ", \"elapsed_s\": " << elapsed
+       << ", \"events_per_s\": " << events * rate
+       << ", \"optical_photons\": " << photons
+       << ", \"optical_photons_per_s\": " << photons * rate
+       << ", \"rss_mb\": " << CurrentRSS()
+       << ", \"sd_w\": [" << unweighted << ", " << weighted << "]"
+       << ", \"threads\": [" << threads.str() << "]}\n";
+    return os.str();
+}
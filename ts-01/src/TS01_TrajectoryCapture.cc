@@ -0,0 +1,192 @@
+//
+//  TS01_TrajectoryCapture.cc
+//  ts_01
+//
+
+#include <algorithm>
+
+#include "G4Event.hh"
+#include "G4RunManager.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4TrackingManager.hh"
+#include "G4TrajectoryContainer.hh"
+#include "TS01_PhotoSD.hh"
+#include "TS01_Run.hh"
+#include "TS01_TrajectoryMessenger.hh"
+#include "TS01_TrajectoryCapture.hh"
+
+namespace
+{
+    // Uniform integer in [0, n), independent of the event random engine
+    G4long Uniform(uint64_t& state, G4long n)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (G4long) ((state >> 11) * (1.0 / 9007199254740992.0) * n);
+    }
+}
+
+TS01_Trajectory::TS01_Trajectory(const G4Track* track, G4int max) :
+    track_id(track->GetTrackID()),
+    parent_id(track->GetParentID()),
+    particle(track->GetDefinition()),
+    momentum(track->GetMomentum()),
+    detected(false),
+    max_points(std::max(max, 2)),
+    steps(0),
+    stride(1)
+{
+    points.reserve(max_points);
+    points.push_back(Point(track->GetPosition()));
+}
+
+G4String TS01_Trajectory::GetParticleName() const
+{
+    return particle->GetParticleName();
+}
+
+G4double TS01_Trajectory::GetCharge() const
+{
+    return particle->GetPDGCharge();
+}
+
+G4int TS01_Trajectory::GetPDGEncoding() const
+{
+    return particle->GetPDGEncoding();
+}
+
+void TS01_Trajectory::AppendStep(const G4Step* step)
+{
+    // The sensitive detector has processed the step by now
+    if (!detected) detected = TS01_PhotoSD::Detected::Is(step->GetTrack());
+
+    end.position = step->GetPostStepPoint()->GetPosition();
+    if (++steps % stride) return;
+
+    points.push_back(end);
+    if ((G4int) points.size() < max_points) return;
+
+    // Full: keep every second point, i.e. every 2 stride-th step
+    for (size_t i=1; 2*i<points.size(); i++) points[i] = points[2*i];
+    points.resize((points.size() + 1) / 2);
+    stride *= 2;
+}
+
+void TS01_Trajectory::MergeTrajectory(G4VTrajectory* other)
+{
+    // Only for suspended tracks, which optical photons never are; the
+    // other trajectory's points are appended as they are
+    const G4int n = other->GetPointEntries();
+    if (GetPointEntries() > (G4int) points.size()) points.push_back(end);
+    for (G4int i=1; i<n; i++) points.push_back(Point(other->GetPoint(i)->GetPosition()));
+    steps = 0;
+    stride = 1;
+    TS01_Trajectory* t = dynamic_cast<TS01_Trajectory*>(other);
+    if (t && t->detected) detected = true;
+}
+
+TS01_TrajectoryCapture::TS01_TrajectoryCapture() :
+    enabled(false),
+    max_photons(200),
+    max_points(16),
+    verbose(1),
+    run(NULL),
+    current(NULL),
+    photons(0),
+    state(0)
+{
+    messenger = new TS01_TrajectoryMessenger(this);
+}
+
+TS01_TrajectoryCapture::~TS01_TrajectoryCapture()
+{
+    Clear();
+    delete messenger;
+}
+
+void TS01_TrajectoryCapture::Clear()
+{
+    for (size_t i=0; i<detected.size(); i++) delete detected[i];
+    for (size_t i=0; i<reservoir.size(); i++) delete reservoir[i];
+    detected.clear();
+    reservoir.clear();
+    photons = 0;
+}
+
+void TS01_TrajectoryCapture::BeginOfEvent(const G4Event* event)
+{
+    Clear();
+    run = static_cast<TS01_Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    state = 0x9E3779B97F4A7C15ULL * (event->GetEventID() + 1);
+}
+
+void TS01_TrajectoryCapture::PreUserTrackingAction(const G4Track* track)
+{
+    current = NULL;
+    if (!enabled || !fpTrackingManager->GetStoreTrajectory()) return;
+    if (track->GetDefinition() != G4OpticalPhoton::OpticalPhotonDefinition()) return;
+
+    // Used by the tracking manager instead of its default trajectory
+    current = new TS01_Trajectory(track, max_points);
+    fpTrackingManager->SetTrajectory(current);
+}
+
+void TS01_TrajectoryCapture::PostUserTrackingAction(const G4Track* track)
+{
+    if (run) run->CountWork(TS01_Run::kWorkSteps, track->GetCurrentStepNumber());
+    if (current == NULL || fpTrackingManager->GimmeTrajectory() != current) return;
+
+    // Taken back, so the event manager does not store it
+    fpTrackingManager->SetTrajectory(NULL);
+    TS01_Trajectory* t = current;
+    current = NULL;
+
+    if (t->IsDetected())
+    {
+        detected.push_back(t);
+        return;
+    }
+
+    // Algorithm R: the n-th photon replaces a random kept one with
+    // probability max_photons / n
+    const G4long n = ++photons;
+    if ((G4int) reservoir.size() < max_photons)
+    {
+        reservoir.push_back(t);
+        return;
+    }
+    const G4long j = Uniform(state, n);
+    if (j < (G4long) reservoir.size())
+    {
+        delete reservoir[j];
+        reservoir[j] = t;
+    }
+    else
+        delete t;
+}
+
+void TS01_TrajectoryCapture::EndOfEvent(const G4Event* event)
+{
+    if (detected.empty() && reservoir.empty()) return;
+
+    G4Event* e = const_cast<G4Event*>(event);
+    G4TrajectoryContainer* trajectories = e->GetTrajectoryContainer();
+    if (trajectories == NULL)
+    {
+        trajectories = new G4TrajectoryContainer;
+        e->SetTrajectoryContainer(trajectories);
+    }
+    for (size_t i=0; i<detected.size(); i++) trajectories->insert(detected[i]);
+    for (size_t i=0; i<reservoir.size(); i++) trajectories->insert(reservoir[i]);
+
+    if (verbose > 0)
+        G4cout << "Event " << event->GetEventID() << ": " << detected.size()
+               << " detected and " << reservoir.size() << " of " << photons
+               << " other optical photon trajectories kept" << G4endl;
+
+    // Owned by the event now
+    detected.clear();
+    reservoir.clear();
+    photons = 0;
+}
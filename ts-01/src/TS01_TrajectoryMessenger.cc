@@ -0,0 +1,61 @@
+//
+//  TS01_TrajectoryMessenger.cc
+//  ts_01
+//
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "TS01_TrajectoryCapture.hh"
+#include "TS01_TrajectoryMessenger.hh"
+
+TS01_TrajectoryMessenger::TS01_TrajectoryMessenger(TS01_TrajectoryCapture* c) :
+    capture(c)
+{
+    trajectory_dir = new G4UIdirectory("/ts01/trajectory/");
+    trajectory_dir->SetGuidance("Bounded-memory optical photon trajectories for visualisation.");
+
+    enable_cmd = new G4UIcmdWithABool("/ts01/trajectory/enable", this);
+    enable_cmd->SetGuidance("Store decimated optical photon trajectories: all photons that reach");
+    enable_cmd->SetGuidance("a sensitive volume and a random sample of the others.  Needs");
+    enable_cmd->SetGuidance("trajectories to be stored (/vis/scene/add/trajectories).");
+    enable_cmd->SetParameterName("enable", true);
+    enable_cmd->SetDefaultValue(true);
+
+    photons_cmd = new G4UIcmdWithAnInteger("/ts01/trajectory/maxPhotons", this);
+    photons_cmd->SetGuidance("Trajectories kept per event of photons that are not detected.");
+    photons_cmd->SetParameterName("photons", false);
+    photons_cmd->SetRange("photons >= 0");
+
+    points_cmd = new G4UIcmdWithAnInteger("/ts01/trajectory/maxPoints", this);
+    points_cmd->SetGuidance("Step points per photon trajectory before it is decimated; the");
+    points_cmd->SetGuidance("start and end of the photon are always kept.");
+    points_cmd->SetParameterName("points", false);
+    points_cmd->SetRange("points >= 2");
+
+    verbose_cmd = new G4UIcmdWithAnInteger("/ts01/trajectory/verbose", this);
+    verbose_cmd->SetGuidance("1 (default): print the trajectories kept at the end of each event.");
+    verbose_cmd->SetParameterName("level", false);
+    verbose_cmd->SetRange("level >= 0");
+}
+
+TS01_TrajectoryMessenger::~TS01_TrajectoryMessenger()
+{
+    delete verbose_cmd;
+    delete points_cmd;
+    delete photons_cmd;
+    delete enable_cmd;
+    delete trajectory_dir;
+}
+
+void TS01_TrajectoryMessenger::SetNewValue(G4UIcommand* cmd, G4String value)
+{
+    if (cmd == enable_cmd)
+        capture->SetEnabled(G4UIcmdWithABool::GetNewBoolValue(value));
+    else if (cmd == photons_cmd)
+        capture->SetMaxPhotons(G4UIcmdWithAnInteger::GetNewIntValue(value));
+    else if (cmd == points_cmd)
+        capture->SetMaxPoints(G4UIcmdWithAnInteger::GetNewIntValue(value));
+    else if (cmd == verbose_cmd)
+        capture->SetVerbose(G4UIcmdWithAnInteger::GetNewIntValue(value));
+}
@@ -0,0 +1,100 @@
+//
+//  TS01_FixedTest.cc
+//  ts_01
+//
+//  Checks of TS01_Fixed: small terms and their squares are kept, sums
+//  do not depend on the order of the terms, and every sum reads back
+//  exactly from what operator<< writes.  Run by ctest.
+//
+
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "TS01_Fixed.hh"
+
+namespace
+{
+    G4int failed = 0;
+
+    void Check(G4bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            G4cout << "FAILED: " << what << G4endl;
+            failed++;
+        }
+    }
+
+    G4bool RoundTrip(const TS01_Fixed& f)
+    {
+        std::ostringstream os;
+        os << f;
+        std::istringstream is(os.str());
+        TS01_Fixed back;
+        return (is >> back) && back == f;
+    }
+}
+
+int main()
+{
+    // Squared weights of thinned events
+    TS01_Fixed sum2;
+    for (G4int i=0; i<1000; i++) sum2 += 0.002*0.002;
+    Check(fabs(sum2.ToDouble() - 0.004) < 1e-11, "1000 x 0.002^2 sums to 0.004");
+    Check(RoundTrip(sum2), "1000 x 0.002^2 round trip");
+
+    std::mt19937_64 engine(12345);
+    std::uniform_real_distribution<G4double> flat(0.0, 1.0);
+    for (G4int trial=0; trial<2000; trial++)
+    {
+        // Terms from 1e-9 to 1e3, some negative, and their squares
+        std::vector<G4double> terms(1 + trial % 50);
+        for (size_t i=0; i<terms.size(); i++)
+        {
+            terms[i] = pow(10.0, -9.0 + 12.0 * flat(engine));
+            if (flat(engine) < 0.2) terms[i] = -terms[i];
+        }
+
+        TS01_Fixed sum, sum_sq, reversed;
+        G4double exact = 0.0, exact_sq = 0.0, size = 0.0;
+        for (size_t i=0; i<terms.size(); i++)
+        {
+            sum    += terms[i];
+            sum_sq += terms[i]*terms[i];
+            exact    += terms[i];
+            exact_sq += terms[i]*terms[i];
+            size     += fabs(terms[i]);
+        }
+        std::reverse(terms.begin(), terms.end());
+        for (size_t i=0; i<terms.size(); i++) reversed += terms[i];
+
+        // Rounding to 2^-48 per term, and to double in the reference sums
+        const G4double tolerance = 1e-14 * terms.size();
+        Check(sum == reversed, "sum independent of order");
+        Check(fabs(sum.ToDouble() - exact) <= tolerance * (1.0 + size), "sum value");
+        Check(fabs(sum_sq.ToDouble() - exact_sq) <= tolerance * (1.0 + exact_sq), "square sum value");
+        Check(RoundTrip(sum), "sum round trip");
+        Check(RoundTrip(sum_sq), "square sum round trip");
+    }
+
+    // Large sums, near the top of the range
+    TS01_Fixed large;
+    for (G4int i=0; i<1000; i++) large += 1.5e19;
+    Check(fabs(large.ToDouble() - 1.5e22) < 1e7, "1000 x 1.5e19 sums to 1.5e22");
+    Check(RoundTrip(large), "large sum round trip");
+
+    // Text that is not a sum
+    const char* bad[] = { "", "-", ".5", "1.5x", "1e3", "1..5" };
+    for (size_t i=0; i<sizeof(bad)/sizeof(bad[0]); i++)
+    {
+        std::istringstream is(bad[i]);
+        TS01_Fixed f;
+        Check(!(is >> f), "malformed sum rejected");
+    }
+
+    G4cout << (failed ? "TS01_FixedTest: failed" : "TS01_FixedTest: passed") << G4endl;
+    return failed ? 1 : 0;
+}